@@ -0,0 +1,149 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/citiroc_types.hpp"
+#include "sabat/citiroc_utils.hpp"
+
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <istream>
+#include <optional>
+
+/**
+ * Decoding of the Citiroc (Janus) binary files, common to all acquisition modes.
+ *
+ * Event in the spectroscopy modes: size (2), board (1), trigger timestamp (8), trigger id (8), channel mask (8),
+ * flags (2), then a hit for each channel in the mask. Event in the timing mode: size (2), board (1), trigger
+ * timestamp (8), number of hits (2), hits. Hit: channel (1), datatype (1), then the fields flagged in the datatype in
+ * order: LG PHA (2), HG PHA (2), ToA (4), ToT (2).
+ */
+namespace spark::citiroc
+{
+
+namespace acq_modes
+{
+constexpr uint8_t spectroscopy {0x01};
+constexpr uint8_t timing {0x02};
+constexpr uint8_t spect_timing {0x03};
+}  // namespace acq_modes
+
+namespace datatypes
+{
+constexpr uint8_t lgpha {0x01};
+constexpr uint8_t hgpha {0x02};
+constexpr uint8_t toa {0x10};
+constexpr uint8_t tot {0x20};
+}  // namespace datatypes
+
+namespace decoder
+{
+
+inline auto read_file_header(std::istream& source) -> types::file_header
+{
+    types::file_header fheader;
+
+    fheader.firmware_ver = std::byteswap(utils::read_n_bytes<uint16_t>(2, source));
+    fheader.janus_rel = std::byteswap(utils::read_n_bytes<uint32_t>(3, source)) >> 8;
+    fheader.board_id = utils::read_n_bytes<uint16_t>(2, source);
+    fheader.run = utils::read_n_bytes<uint16_t>(2, source);
+    fheader.acq_mode = utils::read_n_bytes<uint8_t>(1, source);
+    fheader.e_hists_nbins = utils::read_n_bytes<uint16_t>(2, source);
+    fheader.toa_tot_unit = utils::read_n_bytes<uint8_t>(1, source);
+    fheader.time_lsb = utils::read_n_bytes<uint32_t>(4, source);
+    fheader.run_timestamp = utils::read_n_bytes<uint64_t>(8, source);
+
+    return fheader;
+}
+
+/// Read event header of the spectroscopy and spectroscopy+timing modes, nullopt at the end of data.
+inline auto read_spectroscopy_header(std::istream& source) -> std::optional<types::event_header>
+{
+    types::event_header header;
+
+    header.evsize = utils::read_n_bytes<uint16_t>(2, source);
+
+    if (header.evsize == 0) {
+        return std::nullopt;
+    }
+
+    header.brd = utils::read_n_bytes<uint8_t>(1, source);
+    header.trgts = utils::read_n_bytes<uint64_t>(8, source);
+    header.trgid = utils::read_n_bytes<uint64_t>(8, source);
+    header.chmask = utils::read_n_bytes<uint64_t>(8, source);
+    header.nhits = std::bitset<64>(header.chmask).count();
+    header.flags = utils::read_n_bytes<uint16_t>(2, source);
+
+    return header;
+}
+
+/// Read event header of the timing mode, nullopt at the end of data.
+inline auto read_timing_header(std::istream& source) -> std::optional<types::event_header>
+{
+    types::event_header header;
+
+    header.evsize = utils::read_n_bytes<uint16_t>(2, source);
+
+    if (header.evsize == 0) {
+        return std::nullopt;
+    }
+
+    header.brd = utils::read_n_bytes<uint8_t>(1, source);
+    header.trgts = utils::read_n_bytes<uint64_t>(8, source);
+    header.nhits = utils::read_n_bytes<uint16_t>(2, source);
+
+    return header;
+}
+
+inline auto read_event_header(uint8_t acq_mode, std::istream& source) -> std::optional<types::event_header>
+{
+    return acq_mode == acq_modes::timing ? read_timing_header(source) : read_spectroscopy_header(source);
+}
+
+/// Size of the event header in the acquisition mode, including the event size field.
+constexpr auto header_size(uint8_t acq_mode) -> uint16_t
+{
+    return acq_mode == acq_modes::timing ? 2 + 1 + 8 + 2 : 2 + 1 + 8 + 8 + 8 + 2;
+}
+
+/// Skip the hits of the event, after its header was read.
+inline auto skip_hits(uint8_t acq_mode, const types::event_header& header, std::istream& source) -> void
+{
+    if (header.evsize > header_size(acq_mode)) {
+        source.seekg(header.evsize - header_size(acq_mode), std::ios::cur);
+    }
+}
+
+inline auto read_hit(std::istream& source) -> types::hit
+{
+    types::hit hit;
+
+    hit.channel = utils::read_n_bytes<uint8_t>(1, source);
+    hit.datatype = utils::read_n_bytes<uint8_t>(1, source);
+
+    if (hit.datatype & datatypes::lgpha) {
+        hit.lgpha = utils::read_n_bytes<uint16_t>(2, source);
+    }
+    if (hit.datatype & datatypes::hgpha) {
+        hit.hgpha = utils::read_n_bytes<uint16_t>(2, source);
+    }
+    if (hit.datatype & datatypes::toa) {
+        hit.toa = utils::read_n_bytes<uint32_t>(4, source);
+    }
+    if (hit.datatype & datatypes::tot) {
+        hit.tot = utils::read_n_bytes<uint16_t>(2, source);
+    }
+
+    return hit;
+}
+
+}  // namespace decoder
+
+}  // namespace spark::citiroc
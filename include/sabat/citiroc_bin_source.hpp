@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
@@ -39,18 +40,43 @@ public:
     auto read_current_event() -> bool override;
 
     /**
-     * Set input for the source.
+     * Set input for the source. If another file is already open, it is closed first, so the same source can be
+     * reused for a sequence of files.
      *
      * \param filename input file name
      * \param length length of buffer to read
      */
-    virtual auto set_input(const std::filesystem::path& filepath) -> void { file = filepath; }
+    virtual auto set_input(const std::filesystem::path& filepath) -> void
+    {
+        close();
+        file = filepath;
+    }
 
     auto open() -> bool override;
 
-    auto close() -> bool override { return true; }
+    auto close() -> bool override;
 
-    auto skip_to_event(int64_t new_event) -> void;
+    /**
+     * Register unpacker for a given Citiroc acquisition mode. When any mode unpacker is registered, the unpacker is
+     * selected from the file header on open() instead of the address lookup.
+     *
+     * \param acq_mode acquisition mode as in the file header
+     * \param unp unpacker
+     */
+    auto add_mode_unpacker(uint8_t acq_mode, unpacker* unp) -> void { mode_unpackers[acq_mode] = unp; }
+
+    /**
+     * Position the input at the given event of the file, counted from the first event, by walking the event sizes.
+     *
+     * \return false if the file has fewer events
+     */
+    auto skip_to_event(int64_t new_event) -> bool;
+
+    /// Byte offset in the file of the event read last, or of the first event before any read.
+    auto current_event_offset() const -> uint64_t { return event_offset; }
+
+    /// Position the input at the event starting at the offset, as returned by current_event_offset().
+    auto seek_to_offset(uint64_t offset) -> bool;
 
     auto header() const -> const types::file_header* { return &fheader; }
 
@@ -63,6 +89,11 @@ private:
     types::file_header fheader;  ///< file header
     uint32_t hwid {0};
     uint16_t vaddr {0};
+    uint64_t data_offset {0};   ///< offset of the first event
+    uint64_t event_offset {0};  ///< offset of the current event
+
+    std::map<uint8_t, unpacker*> mode_unpackers;  ///< unpackers per acquisition mode
+    unpacker* mode_unpacker {nullptr};             ///< unpacker selected for the current file
 };
 
 }  // namespace spark::citiroc
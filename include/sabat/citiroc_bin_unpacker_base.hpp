@@ -0,0 +1,292 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include "sabat/citiroc_bin_decoder.hpp"
+#include "sabat/citiroc_buffer_decoder.hpp"
+#include "sabat/citiroc_types.hpp"
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_parameters.hpp"
+
+#include <spark/core/unpacker.hpp>
+#include <spark/parameters/database.hpp>
+#include <spark/spark.hpp>
+
+#include <array>
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint16_t
+#include <istream>
+#include <optional>
+#include <string>
+#include <tuple>
+
+namespace spark
+{
+
+class category;
+
+namespace citiroc
+{
+
+/**
+ * Reading of the Citiroc events of the given acquisition mode into the EventHeader and SiPMRaw categories, the common
+ * part of the Citiroc unpackers. The events are read from a stream with the decoder or from a memory buffer with the
+ * buffer decoder. The categories and the lookup table are template parameters, so the unpacking can be run also
+ * outside of the framework, e.g. to compare the decoders.
+ *
+ * Channels set in the mask of the board are dropped before any object is created. In the spectroscopy modes an event
+ * with only masked channels in its channel mask is skipped by its event size without reading the hits. Hits mapped by
+ * the lookup table to the same (module, SiPM) are stored in the same object.
+ *
+ * \tparam AcqMode acquisition mode, selects the event header format
+ * \tparam StorePha store LG and HG PHA of the hits
+ * \tparam StoreTime store ToA and ToT of the hits
+ * \tparam Category category of the objects, with get_object() and make_object_unsafe()
+ * \tparam Lookup pointer-like access to the lookup table, -> get({0, channel}) gives (module, SiPM)
+ */
+template<uint8_t AcqMode, bool StorePha, bool StoreTime, typename Category, typename Lookup>
+class event_unpacker
+{
+public:
+    event_unpacker(Category& cat_event_header,
+                   Category& cat_sipm_raw,
+                   Lookup& lookup,
+                   const std::array<uint64_t, 256>& masks)
+        : cat_event_header(cat_event_header)
+        , cat_sipm_raw(cat_sipm_raw)
+        , lookup(lookup)
+        , masks(masks)
+    {
+    }
+
+    /// Read an event, false at the end of data or if the event is cut short.
+    template<typename Source>
+    auto read_event(Source& source) -> bool
+    {
+        auto header = read_header(source);
+
+        if (!header) {
+            return false;
+        }
+
+        spdlog::debug(
+            " Event :  Size {:#06x}  Board {:3d}  trgTS {:#018x}  trgID {:#018x}  ChMask {:#018x}  Nhits {:4d}  flags "
+            "{:#04x}",
+            header->evsize,
+            header->brd,
+            header->trgts,
+            header->trgid,
+            header->chmask,
+            header->nhits,
+            header->flags);
+
+        auto hdr_obj = cat_event_header.template make_object_unsafe<EventHeader>({0});
+        hdr_obj->board = header->brd;
+        hdr_obj->trgts = header->trgts;
+        hdr_obj->trgid = header->trgid;
+        hdr_obj->chmask = header->chmask;
+        hdr_obj->flags = header->flags;
+        hdr_obj->nhits = header->nhits;
+
+        const auto mask = masks[header->brd];
+
+        if constexpr (AcqMode != acq_modes::timing) {
+            if (header->chmask != 0 and (header->chmask & ~mask) == 0) {
+                return skip_hits(*header, source);
+            }
+        }
+
+        for (int i = 0; i < header->nhits; ++i) {
+            auto hit = read_hit(source);
+            if (!hit) {
+                return false;
+            }
+            if (hit->channel < 64 and (mask >> hit->channel & 1u) != 0) {
+                continue;
+            }
+            store_hit(i, *hit);
+        }
+
+        return true;
+    }
+
+private:
+    static auto read_header(std::istream& source) -> std::optional<types::event_header>
+    {
+        auto header = decoder::read_event_header(AcqMode, source);
+        return source ? header : std::nullopt;
+    }
+
+    static auto read_header(buffer_decoder::cursor& cur) -> std::optional<types::event_header>
+    {
+        return buffer_decoder::read_event_header(AcqMode, cur);
+    }
+
+    static auto read_hit(std::istream& source) -> std::optional<types::hit>
+    {
+        auto hit = decoder::read_hit(source);
+        if (!source) {
+            return std::nullopt;
+        }
+        return hit;
+    }
+
+    static auto read_hit(buffer_decoder::cursor& cur) -> std::optional<types::hit>
+    {
+        return buffer_decoder::read_hit(cur);
+    }
+
+    static auto skip_hits(const types::event_header& header, std::istream& source) -> bool
+    {
+        decoder::skip_hits(AcqMode, header, source);
+        return static_cast<bool>(source);
+    }
+
+    static auto skip_hits(const types::event_header& header, buffer_decoder::cursor& cur) -> bool
+    {
+        return buffer_decoder::skip_hits(AcqMode, header, cur);
+    }
+
+    static auto to_string(const std::optional<int>& v) -> std::string { return v ? std::to_string(*v) : "-"; }
+
+    auto store_hit(int n, const types::hit& hit) -> void
+    {
+        spdlog::debug("  Hit {:4d}  Channel {:3d}  DataType {:#04x}  LG PHA {:6s}  HG PHA {:6s}  ToA {:10s}  ToT {:6s}",
+                      n,
+                      hit.channel,
+                      hit.datatype,
+                      to_string(hit.lgpha),
+                      to_string(hit.hgpha),
+                      to_string(hit.toa),
+                      to_string(hit.tot));
+
+        auto [mod, sipm] = lookup->get({0, hit.channel});
+
+        auto obj = cat_sipm_raw.template get_object<SiPMRaw>({mod, sipm});  // FIXME use tuples?
+        if (!obj) {
+            obj = cat_sipm_raw.template make_object_unsafe<SiPMRaw>({mod, sipm});
+        }
+
+        obj->board = mod;
+        obj->channel = hit.channel;
+        obj->sipm = sipm;
+
+        if constexpr (StorePha) {
+            obj->lgpha = hit.lgpha.value_or(-1);
+            obj->hgpha = hit.hgpha.value_or(-1);
+        }
+
+        if constexpr (StoreTime) {
+            obj->toa = hit.toa.value_or(-1);
+            if (obj->toa != -1) {  // as the 1 LSB = 0.5 ns, do conversion to ns
+                obj->toa *= 0.5;
+            }
+            obj->tot = hit.tot.value_or(-1);
+            if (obj->tot != -1) {  // as the 1 LSB = 0.5 ns, do conversion to ns
+                obj->tot *= 0.5;
+            }
+        }
+    }
+
+    Category& cat_event_header;
+    Category& cat_sipm_raw;
+    Lookup& lookup;
+    const std::array<uint64_t, 256>& masks;  ///< channel mask per hardware board
+};
+
+/**
+ * Common part of the Citiroc unpackers: reads the events of the given acquisition mode with event_unpacker and stores
+ * the hits in SiPMRaw.
+ *
+ * The channel mask of the board is taken from SabatChannelMask. The mask is optional, boards without an entry are not
+ * masked; it is resolved per board in init() and again in reinit() for the parameters of each run.
+ *
+ * \tparam AcqMode acquisition mode, selects the event header format
+ * \tparam StorePha store LG and HG PHA of the hits
+ * \tparam StoreTime store ToA and ToT of the hits
+ */
+template<typename LookupTable, uint8_t AcqMode, bool StorePha, bool StoreTime>
+class SABAT_EXPORT bin_unpacker_base : public unpacker
+{
+public:
+    using unpacker::unpacker;
+
+    bin_unpacker_base(const bin_unpacker_base&) = delete;
+    bin_unpacker_base(bin_unpacker_base&&) = delete;
+
+    auto operator=(const bin_unpacker_base&) -> bin_unpacker_base& = delete;
+    auto operator=(bin_unpacker_base&&) -> bin_unpacker_base& = delete;
+
+    ~bin_unpacker_base() override = default;
+
+    auto init() -> bool override
+    {
+        unpacker::init();
+
+        cat_sipm_raw = model()->template build_category<SiPMRaw>(SabatCategories::SiPMRaw);
+
+        if (cat_sipm_raw == nullptr) {
+            spdlog::critical("[{}] No SiPMRaw category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_event_header = model()->template build_category<EventHeader>(SabatCategories::EventHeader);
+
+        if (cat_event_header == nullptr) {
+            spdlog::critical("[{}] No EventHeader category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        sabat_lookup = db()->template get_container<LookupTable>("SabatLookup");
+
+        reader.emplace(*cat_event_header, *cat_sipm_raw, sabat_lookup, masks);
+
+        return reinit();
+    }
+
+    /// The masks are read again for the parameters of the new run.
+    auto reinit() -> bool override
+    {
+        masks.fill(0);
+        if (auto channel_mask = sabat::find_container<SabatChannelMask>(*db(), "SabatChannelMask")) {
+            for (size_t brd = 0; brd < masks.size(); ++brd) {
+                if (auto row = sabat::find_row(*channel_mask, static_cast<uint8_t>(brd))) {
+                    masks[brd] = std::get<0>(*row);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    auto execute(uint64_t /*event*/,
+                 uint64_t /*seq_number*/,
+                 uint16_t /*subevent*/,
+                 std::istream& source,
+                 size_t /*length*/) -> bool override
+    {
+        // spdlog::debug(" Unpack Event :  {}  SeqNim {}  SubEVT {}  Length {}", event, seq_number, subevent, length);
+        return reader->read_event(source);
+    }
+
+private:
+    category* cat_sipm_raw {nullptr};
+    category* cat_event_header {nullptr};
+    spark::container_wrapper<LookupTable> sabat_lookup;
+    std::array<uint64_t, 256> masks {};  ///< SabatChannelMask per hardware board
+    std::optional<event_unpacker<AcqMode, StorePha, StoreTime, category, spark::container_wrapper<LookupTable>>>
+        reader;
+};
+
+}  // namespace citiroc
+
+}  // namespace spark
@@ -0,0 +1,28 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/citiroc_bin_decoder.hpp"
+#include "sabat/citiroc_bin_unpacker_base.hpp"
+
+namespace spark::citiroc
+{
+
+/**
+ * Unpacker of the combined spectroscopy and timing mode, stores LG and HG PHA, ToA and ToT of the hits in one pass.
+ */
+template<typename LookupTable>
+class SABAT_EXPORT bin_unpacker_spect_timing
+    : public bin_unpacker_base<LookupTable, acq_modes::spect_timing, true, true>
+{
+public:
+    using bin_unpacker_base<LookupTable, acq_modes::spect_timing, true, true>::bin_unpacker_base;
+};
+
+}  // namespace spark::citiroc
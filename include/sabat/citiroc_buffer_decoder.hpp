@@ -0,0 +1,173 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/citiroc_bin_decoder.hpp"
+#include "sabat/citiroc_types.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+/**
+ * Decoding of the Citiroc binary data from a memory buffer, an alternative to the stream decoder in
+ * citiroc_bin_decoder.hpp with the same results. The bounds are checked once per header and per hit instead of per
+ * field, a truncated header or hit is reported as nullopt.
+ */
+namespace spark::citiroc::buffer_decoder
+{
+
+class cursor
+{
+public:
+    explicit cursor(std::span<const std::byte> data)
+        : p(data.data())
+        , end(data.data() + data.size())
+    {
+    }
+
+    auto remaining() const -> size_t { return static_cast<size_t>(end - p); }
+
+    /// Read n little-endian bytes into T, the caller checks the bounds.
+    template<typename T>
+    auto take(size_t n = sizeof(T)) -> T
+    {
+        T ret {0};
+        std::memcpy(&ret, p, n);
+        p += n;
+        return ret;
+    }
+
+    auto skip(size_t n) -> void { p += n; }
+
+private:
+    const std::byte* p;
+    const std::byte* end;
+};
+
+constexpr size_t file_header_size {2 + 3 + 2 + 2 + 1 + 2 + 1 + 4 + 8};
+
+/// Size of a hit with the datatype, including the channel and datatype.
+constexpr auto hit_size(uint8_t datatype) -> size_t
+{
+    return 2 + ((datatype & datatypes::lgpha) ? 2 : 0) + ((datatype & datatypes::hgpha) ? 2 : 0)
+           + ((datatype & datatypes::toa) ? 4 : 0) + ((datatype & datatypes::tot) ? 2 : 0);
+}
+
+inline auto read_file_header(cursor& cur) -> std::optional<types::file_header>
+{
+    if (cur.remaining() < file_header_size) {
+        return std::nullopt;
+    }
+
+    types::file_header fheader;
+
+    fheader.firmware_ver = std::byteswap(cur.take<uint16_t>(2));
+    fheader.janus_rel = std::byteswap(cur.take<uint32_t>(3)) >> 8;
+    fheader.board_id = cur.take<uint16_t>(2);
+    fheader.run = cur.take<uint16_t>(2);
+    fheader.acq_mode = cur.take<uint8_t>(1);
+    fheader.e_hists_nbins = cur.take<uint16_t>(2);
+    fheader.toa_tot_unit = cur.take<uint8_t>(1);
+    fheader.time_lsb = cur.take<uint32_t>(4);
+    fheader.run_timestamp = cur.take<uint64_t>(8);
+
+    return fheader;
+}
+
+/// Read event header, nullopt at the end of data or if truncated.
+inline auto read_event_header(uint8_t acq_mode, cursor& cur) -> std::optional<types::event_header>
+{
+    if (cur.remaining() < decoder::header_size(acq_mode)) {
+        return std::nullopt;
+    }
+
+    types::event_header header;
+
+    header.evsize = cur.take<uint16_t>(2);
+
+    if (header.evsize == 0) {
+        return std::nullopt;
+    }
+
+    header.brd = cur.take<uint8_t>(1);
+    header.trgts = cur.take<uint64_t>(8);
+
+    if (acq_mode == acq_modes::timing) {
+        header.nhits = cur.take<uint16_t>(2);
+    } else {
+        header.trgid = cur.take<uint64_t>(8);
+        header.chmask = cur.take<uint64_t>(8);
+        header.nhits = std::popcount(header.chmask);
+        header.flags = cur.take<uint16_t>(2);
+    }
+
+    return header;
+}
+
+/// Skip the hits of the event after its header was read, false if the event size points past the end of data.
+inline auto skip_hits(uint8_t acq_mode, const types::event_header& header, cursor& cur) -> bool
+{
+    if (header.evsize > decoder::header_size(acq_mode)) {
+        const size_t n = header.evsize - decoder::header_size(acq_mode);
+        if (cur.remaining() < n) {
+            return false;
+        }
+        cur.skip(n);
+    }
+
+    return true;
+}
+
+/// Read a hit, nullopt if truncated.
+inline auto read_hit(cursor& cur) -> std::optional<types::hit>
+{
+    static constexpr auto sizes = []
+    {
+        std::array<uint8_t, 256> s {};
+        for (size_t i = 0; i < s.size(); ++i) {
+            s[i] = static_cast<uint8_t>(hit_size(static_cast<uint8_t>(i)));
+        }
+        return s;
+    }();
+
+    if (cur.remaining() < 2) {
+        return std::nullopt;
+    }
+
+    types::hit hit;
+
+    hit.channel = cur.take<uint8_t>(1);
+    hit.datatype = cur.take<uint8_t>(1);
+
+    if (cur.remaining() < sizes[hit.datatype] - 2U) {
+        return std::nullopt;
+    }
+
+    if (hit.datatype & datatypes::lgpha) {
+        hit.lgpha = cur.take<uint16_t>(2);
+    }
+    if (hit.datatype & datatypes::hgpha) {
+        hit.hgpha = cur.take<uint16_t>(2);
+    }
+    if (hit.datatype & datatypes::toa) {
+        hit.toa = cur.take<uint32_t>(4);
+    }
+    if (hit.datatype & datatypes::tot) {
+        hit.tot = cur.take<uint16_t>(2);
+    }
+
+    return hit;
+}
+
+}  // namespace spark::citiroc::buffer_decoder
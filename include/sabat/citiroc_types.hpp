@@ -16,12 +16,17 @@
 namespace spark::citiroc::types
 {
 
-struct timing_hit
+/// Hit as read from the file, only the fields flagged in the datatype are present.
+struct hit
 {
     uint8_t channel {0};
     uint8_t datatype {0};
+    std::optional<int> lgpha;
+    std::optional<int> hgpha;
     std::optional<int> toa;
     std::optional<int> tot;
+
+    auto operator==(const hit&) const -> bool = default;
 };
 
 struct event_header
@@ -29,7 +34,12 @@ struct event_header
     uint16_t evsize {0};
     uint8_t brd {0};
     uint64_t trgts {0};
+    uint64_t trgid {0};   ///< spectroscopy modes only
+    uint64_t chmask {0};  ///< spectroscopy modes only
+    uint16_t flags {0};   ///< spectroscopy modes only
     uint16_t nhits {0};
+
+    auto operator==(const event_header&) const -> bool = default;
 };
 
 template<typename T>
@@ -12,20 +12,25 @@
 
 #include "sabat/sabat_categories.hpp"
 #include "sabat/sabat_detector.hpp"
+#include "sabat/sabat_processing_setup.hpp"
 
 #include <spark/spark.hpp>
 
+#include <utility>
+
 namespace sabat
 {
 
 template<typename DetectorVariant, typename Categories = SabatCategories>
 struct SABAT_EXPORT sabatsys : public spark::sparksys
 {
-    sabatsys()
+    /// The detector sets up the tasks of the features engaged in the setup.
+    explicit sabatsys(processing_setup setup = {})
         : spark::sparksys(std::in_place_type_t<Categories> {})
+        , features(std::move(setup))
     {
         spdlog::info("..:: SETUP SABAT SYSTEM ::..");
-        system().template make_detector<DetectorVariant>("SabatEye");
+        system().template make_detector<DetectorVariant>("SabatEye", features);
     }
 
     auto init(size_t runid = 0) -> void
@@ -33,6 +38,11 @@ struct SABAT_EXPORT sabatsys : public spark::sparksys
         spdlog::info("..:: INIT SABAT SYSTEM ::..");
         pardb().init_containers(runid);
     }
+
+    auto setup() -> processing_setup& { return features; }
+
+private:
+    processing_setup features;
 };
 
 using SabatMain = sabat::sabatsys<sabat_detector>;
@@ -12,13 +12,73 @@
 
 #include <TObject.h>
 
+#include <cstddef>
+
 enum class SabatCategories : std::uint8_t
 {
-    GeantTrack = 0,    ///< geant track
-    GeantSiPMRaw = 1,  ///< SiPM geant hit
-    SiPMRaw = 20,      ///< SiPM raw data
-    SiPMCal = 21,      ///< SiPM cal data
-    PhotonHit = 22,    ///< hit
+    GeantTrack = 0,      ///< geant track
+    GeantSiPMRaw = 1,    ///< SiPM geant hit
+    EventHeader = 10,    ///< event header
+    SiPMRaw = 20,        ///< SiPM raw data
+    SiPMCal = 21,        ///< SiPM cal data
+    PhotonHit = 22,      ///< hit
+    SiPMTimeOrder = 23,  ///< SiPM cal hits in time order
+    CoincWindow = 24,    ///< coincidence windows
+};
+
+/// Dimensions of the categories as registered by the detector; sources must keep their locators within them.
+namespace sabat::category_size
+{
+inline constexpr size_t modules {2};            ///< modules of SiPMRaw, SiPMCal and PhotonHit
+inline constexpr size_t sipms {64};             ///< SiPMs per module of SiPMRaw and SiPMCal
+inline constexpr size_t geant_tracks {1000};    ///< GeantTrack objects per event
+inline constexpr size_t geant_deposits {1024};  ///< GeantSiPMRaw objects per event
+}  // namespace sabat::category_size
+
+struct GeantTrack : public TObject
+{
+    GeantTrack() = default;
+
+    int track_id {-1};
+    int parent_id {-1};
+    int pdg {0};
+    float x {0};  ///< vertex [mm]
+    float y {0};
+    float z {0};
+    float px {0};  ///< momentum at vertex [MeV]
+    float py {0};
+    float pz {0};
+    float energy {0};  ///< kinetic energy at vertex [MeV]
+
+    ClassDef(GeantTrack, 1)
+};
+
+struct GeantSiPMRaw : public TObject
+{
+    GeantSiPMRaw() = default;
+
+    int event {-1};  ///< simulated event number
+    int board {-1};
+    int channel {-1};
+    int track_id {-1};
+    float energy {0};  ///< deposited energy [MeV]
+    float time {0};    ///< time of the deposit [ns]
+
+    ClassDef(GeantSiPMRaw, 1)
+};
+
+struct EventHeader : public TObject
+{
+    EventHeader() = default;
+
+    int board {-1};
+    uint64_t trgts {0};   ///< trigger timestamp
+    uint64_t trgid {0};   ///< trigger id, simulated event number for the simulation
+    uint64_t chmask {0};  ///< channel mask
+    int flags {0};
+    int nhits {0};
+
+    ClassDef(EventHeader, 1)
 };
 
 struct SiPMRaw : public TObject
@@ -60,3 +120,26 @@ struct PhotonHit : public TObject
 
     ClassDef(PhotonHit, 1)
 };
+
+struct SiPMTimeIndex : public TObject
+{
+    SiPMTimeIndex() = default;
+
+    int cal_index {-1};  ///< index of the hit in SiPMCal
+    int window {-1};     ///< coincidence window of the hit
+    float toa {0};
+
+    ClassDef(SiPMTimeIndex, 1)
+};
+
+struct CoincWindow : public TObject
+{
+    CoincWindow() = default;
+
+    int begin {-1};  ///< first SiPMTimeOrder index of the window
+    int end {-1};    ///< one past the last SiPMTimeOrder index of the window
+    float t_begin {0};
+    float t_end {0};
+
+    ClassDef(CoincWindow, 1)
+};
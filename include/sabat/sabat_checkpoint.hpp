@@ -0,0 +1,146 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include "sabat/sabat_event_index.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sabat
+{
+
+/**
+ * Consistent state of a processing job: the output tree holds the first `entries` events and the processing continues
+ * with the event starting at `offset` of the input.
+ */
+struct checkpoint
+{
+    std::filesystem::path input;
+    uint64_t offset {0};   ///< byte offset of the next event in the input
+    int64_t event {0};     ///< number of the next event in the input
+    int64_t entries {0};   ///< entries of the output tree to keep
+    uint16_t run {0};      ///< run of the parameters
+};
+
+/// Checkpointing of the current job, set by the application.
+struct checkpoint_settings
+{
+    std::filesystem::path file;               ///< checkpoint file, empty to disable
+    std::filesystem::path index_file;         ///< event index records saved with the checkpoints, empty to disable
+    std::filesystem::path output;             ///< output file to flush at the checkpoints
+    int64_t interval {0};                     ///< events between the checkpoints
+    checkpoint start;                         ///< state at the beginning of the job, non-zero when resumed
+    std::function<uint64_t()> input_offset;   ///< offset of the current event in the input
+    std::function<bool(int64_t)> save_state;  ///< saves the other outputs of the entries, called before each checkpoint
+};
+
+/// Checkpoint file of the output file.
+inline auto checkpoint_file_for(const std::filesystem::path& output) -> std::filesystem::path
+{
+    auto file = output;
+    file += ".ckpt";
+    return file;
+}
+
+/// Event index records of the entries saved by the checkpoints of the output file, to complete the index on resume.
+inline auto checkpoint_index_file_for(const std::filesystem::path& output) -> std::filesystem::path
+{
+    auto file = output;
+    file += ".ckpt.idx";
+    return file;
+}
+
+/// State of the outputs other than the tree (monitor, hot channels) at the last checkpoint of the output file.
+inline auto checkpoint_state_file_for(const std::filesystem::path& output) -> std::filesystem::path
+{
+    auto file = output;
+    file += ".ckpt.state";
+    return file;
+}
+
+/// Continuation output written by the resumed job, appended to the output at the end.
+inline auto continuation_file_for(const std::filesystem::path& output) -> std::filesystem::path
+{
+    auto file = output;
+    file.replace_extension(".cont" + output.extension().string());
+    return file;
+}
+
+/// Write the checkpoint atomically, the previous one stays valid until the new one is complete.
+SABAT_EXPORT auto write_checkpoint(const std::filesystem::path& filepath, const checkpoint& ckpt) -> bool;
+
+SABAT_EXPORT auto read_checkpoint(const std::filesystem::path& filepath) -> std::optional<checkpoint>;
+
+/// Append the index records to the checkpoint index file.
+SABAT_EXPORT auto append_checkpoint_index(const std::filesystem::path& filepath,
+                                          std::span<const event_index_record> records) -> bool;
+
+/**
+ * Read the first n records of the checkpoint index file and cut the file to them, so that the resumed job appends
+ * after them.
+ *
+ * \return the records, nullopt if the file holds fewer records
+ */
+SABAT_EXPORT auto restore_checkpoint_index(const std::filesystem::path& filepath, size_t n)
+    -> std::optional<std::vector<event_index_record>>;
+
+/**
+ * Flush the baskets and the header of the open output tree into the file, so the file can be read back with all the
+ * entries filled so far if the process dies (TTree::AutoSave("SaveSelf")).
+ *
+ * \return number of entries saved, nullopt if the output is not open
+ */
+SABAT_EXPORT auto save_output(const std::filesystem::path& filepath, std::string_view tree_name)
+    -> std::optional<int64_t>;
+
+/**
+ * Concatenate the parts into the target file. Trees of the same name are concatenated, each taking at most max_entries
+ * entries in total (negative for all), so that per-entry trees like the event index stay aligned with the event tree.
+ * Other objects are copied from the first part holding them. The target is written aside and renamed at the end, so it
+ * may be one of the parts.
+ *
+ * \return number of entries in the target, nullopt on error
+ */
+SABAT_EXPORT auto merge_outputs(std::span<const std::filesystem::path> parts,
+                                const std::filesystem::path& target,
+                                std::string_view tree_name,
+                                int64_t max_entries = -1) -> std::optional<int64_t>;
+
+/**
+ * Append the trees of the part to the trees of the same name in the target file, opened for update, so the entries
+ * already in the target are not rewritten. Each tree takes at most max_entries entries in total (negative for all).
+ * Other objects of the part are copied if the target does not hold them.
+ *
+ * \return number of entries of the tree in the target, nullopt on error
+ */
+SABAT_EXPORT auto append_output(const std::filesystem::path& target,
+                                const std::filesystem::path& part,
+                                std::string_view tree_name,
+                                int64_t max_entries = -1) -> std::optional<int64_t>;
+
+/**
+ * Cut the tree of the target file back to max_entries entries, in place. The tree holds more entries than its
+ * checkpoint only if the process died between saving the output and writing the checkpoint; only then the kept entries
+ * are copied into a new tree, which replaces the old one.
+ *
+ * \return number of entries of the tree, nullopt on error
+ */
+SABAT_EXPORT auto cut_output(const std::filesystem::path& target, std::string_view tree_name, int64_t max_entries)
+    -> std::optional<int64_t>;
+
+}  // namespace sabat
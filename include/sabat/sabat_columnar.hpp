@@ -0,0 +1,95 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+struct SiPMRaw;
+struct SiPMCal;
+struct PhotonHit;
+
+namespace sabat
+{
+
+enum class columnar_format : uint8_t
+{
+    parquet,    ///< Parquet file, a row group per batch
+    arrow_ipc,  ///< Arrow IPC stream
+};
+
+/// Columnar format from its name: parquet, ipc.
+SABAT_EXPORT auto columnar_format_from_name(std::string_view name) -> std::optional<columnar_format>;
+
+/// File extension of the format, with the dot.
+SABAT_EXPORT auto columnar_extension(columnar_format format) -> std::string_view;
+
+/// The library was built with the Arrow export (SABAT_WITH_ARROW).
+constexpr auto has_columnar_export() -> bool
+{
+#ifdef SABAT_HAS_ARROW
+    return true;
+#else
+    return false;
+#endif
+}
+
+struct columnar_options
+{
+    std::filesystem::path path;  ///< output file, empty to disable
+    columnar_format format {columnar_format::parquet};
+    size_t batch_events {10000};  ///< events per record batch, bounds the memory of the export
+};
+
+/**
+ * Writes the events as Arrow record batches, one row per event: trgts, trgid, and list<struct> columns sipm_raw,
+ * sipm_cal and photon_hit with the fields of the categories. The objects are appended directly into the column
+ * builders, a batch is written out when it has the configured number of events.
+ *
+ * Without the Arrow support open() always fails.
+ */
+class SABAT_EXPORT columnar_writer
+{
+public:
+    columnar_writer();
+    columnar_writer(const columnar_writer&) = delete;
+    columnar_writer(columnar_writer&&) noexcept;
+
+    auto operator=(const columnar_writer&) -> columnar_writer& = delete;
+    auto operator=(columnar_writer&&) noexcept -> columnar_writer&;
+
+    ~columnar_writer();
+
+    auto open(const columnar_options& options) -> bool;
+
+    /// Write the pending batch and close the file.
+    auto close() -> bool;
+
+    auto is_open() const -> bool;
+
+    auto begin_event(uint64_t trgts, uint64_t trgid) -> void;
+    auto append(const SiPMRaw& obj) -> void;
+    auto append(const SiPMCal& obj) -> void;
+    auto append(const PhotonHit& obj) -> void;
+
+    /// Finish the row, writes the batch when full. False on an Arrow error.
+    auto end_event() -> bool;
+
+private:
+    struct impl;
+    std::unique_ptr<impl> d;
+};
+
+}  // namespace sabat
@@ -15,3 +15,7 @@
 
 using SabatLookup = spark::lookup_table<std::tuple<uint8_t, uint8_t>, std::tuple<uint8_t, uint8_t>>;
 using SiPMCalPar = spark::tabular_par<std::tuple<uint8_t, uint8_t>, std::tuple<float, float, int>>;
+using SiPMCoincPar = spark::tabular_par<std::tuple<uint8_t>, std::tuple<float>>;
+using SabatGeometryPar = spark::tabular_par<std::tuple<uint8_t, uint8_t>, std::tuple<int, float, float, float>>;
+using SiPMDigiPar = spark::tabular_par<std::tuple<uint8_t>, std::tuple<float, float, float, float, float, float>>;
+using SabatChannelMask = spark::tabular_par<std::tuple<uint8_t>, std::tuple<uint64_t>>;
@@ -0,0 +1,147 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_categories.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sabat
+{
+
+inline constexpr std::array<std::pair<std::string_view, SabatCategories>, 8> category_names {{
+    {"GeantTrack", SabatCategories::GeantTrack},
+    {"GeantSiPMRaw", SabatCategories::GeantSiPMRaw},
+    {"EventHeader", SabatCategories::EventHeader},
+    {"SiPMRaw", SabatCategories::SiPMRaw},
+    {"SiPMCal", SabatCategories::SiPMCal},
+    {"PhotonHit", SabatCategories::PhotonHit},
+    {"SiPMTimeOrder", SabatCategories::SiPMTimeOrder},
+    {"CoincWindow", SabatCategories::CoincWindow},
+}};
+
+inline auto category_from_name(std::string_view name) -> std::optional<SabatCategories>
+{
+    auto it = std::ranges::find(category_names, name, &std::pair<std::string_view, SabatCategories>::first);
+    if (it == category_names.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+/**
+ * Tracks which categories are needed in the current processing.
+ *
+ * The application declares the categories stored by the writer, consumer tasks declare the categories they read.
+ * Producer tasks register their inputs and outputs and skip the execution when none of their outputs is needed,
+ * directly or through another needed producer. Until any stored category is declared all categories are needed.
+ *
+ * The declarations are made in the tasks init(), the closure is updated with each of them, so the per-event queries
+ * are plain lookups without any mutable state.
+ */
+class category_demand
+{
+public:
+    using category_set = std::bitset<256>;
+
+    /// Declare category stored by the writer. The first call switches off storing of all categories.
+    auto store(SabatCategories cat) -> void
+    {
+        store_all = false;
+        required.set(index(cat));
+        needed = resolve();
+    }
+
+    auto store(std::initializer_list<SabatCategories> cats) -> void
+    {
+        for (auto cat : cats) {
+            store(cat);
+        }
+    }
+
+    /// Declare category read by a consumer.
+    auto require(SabatCategories cat) -> void
+    {
+        required.set(index(cat));
+        needed = resolve();
+    }
+
+    auto add_producer(std::span<const SabatCategories> inputs, std::span<const SabatCategories> outputs) -> void
+    {
+        producer prod {to_set(inputs), to_set(outputs)};
+        if (std::ranges::find(producers, prod) == producers.end()) {
+            producers.push_back(prod);
+            needed = resolve();
+        }
+    }
+
+    auto is_required(SabatCategories cat) const -> bool { return store_all or needed.test(index(cat)); }
+
+    auto any_required(std::span<const SabatCategories> cats) const -> bool
+    {
+        if (store_all) {
+            return true;
+        }
+
+        return std::ranges::any_of(cats, [&](auto cat) { return needed.test(index(cat)); });
+    }
+
+private:
+    struct producer
+    {
+        category_set inputs;
+        category_set outputs;
+
+        auto operator==(const producer&) const -> bool = default;
+    };
+
+    static constexpr auto index(SabatCategories cat) -> size_t { return static_cast<size_t>(cat); }
+
+    static auto to_set(std::span<const SabatCategories> cats) -> category_set
+    {
+        category_set set;
+        for (auto cat : cats) {
+            set.set(index(cat));
+        }
+        return set;
+    }
+
+    /// Required categories closed over the producers inputs.
+    auto resolve() const -> category_set
+    {
+        auto closure = required;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const auto& prod : producers) {
+                if ((prod.outputs & closure).any() and (prod.inputs & ~closure).any()) {
+                    closure |= prod.inputs;
+                    changed = true;
+                }
+            }
+        }
+        return closure;
+    }
+
+    bool store_all {true};
+    category_set required;
+    std::vector<producer> producers;
+    category_set needed;  ///< resolve() of the current declarations, updated by each of them
+};
+
+}  // namespace sabat
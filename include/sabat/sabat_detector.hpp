@@ -11,33 +11,133 @@
 #include "sabat/sabat_export.hpp"
 
 #include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_processing_setup.hpp"
 #include "sabat/sabat_task_calibration.hpp"
+#include "sabat/sabat_task_checkpoint.hpp"
 #include "sabat/sabat_task_clustering.hpp"
+#include "sabat/sabat_task_columnar_writer.hpp"
+#include "sabat/sabat_task_digitization.hpp"
+#include "sabat/sabat_task_dst_writer.hpp"
+#include "sabat/sabat_task_event_index.hpp"
+#include "sabat/sabat_task_graph.hpp"
+#include "sabat/sabat_task_hot_channels.hpp"
+#include "sabat/sabat_task_monitor.hpp"
+#include "sabat/sabat_task_time_sorting.hpp"
 
 #include <spark/core/detector.hpp>
 #include <spark/core/task_manager.hpp>
 
+#include <utility>
+
+/**
+ * Sabat detector: categories, parameter containers and tasks. The reconstruction tasks are always set up, the tasks of
+ * the optional features only when they are engaged in the processing setup, each with its settings.
+ */
 class SABAT_EXPORT sabat_detector : public spark::detector
 {
 public:
-    using detector::detector;
+    template<typename Name>
+    sabat_detector(Name&& name, sabat::processing_setup& setup)
+        : detector(std::forward<Name>(name))
+        , setup(setup)
+    {
+    }
 
     auto setup_categories(spark::category_manager& cat_mgr) -> void override
     {
-        cat_mgr.register_category(SabatCategories::SiPMRaw, "SiPMRaw", {2, 64}, false);
-        cat_mgr.register_category(SabatCategories::SiPMCal, "SiPMCal", {2, 64}, false);
-        cat_mgr.register_category(SabatCategories::PhotonHit, "PhotonHit", {2, 10}, false);
+        namespace size = sabat::category_size;
+
+        cat_mgr.register_category(SabatCategories::GeantTrack, "GeantTrack", {size::geant_tracks}, true);
+        cat_mgr.register_category(SabatCategories::GeantSiPMRaw, "GeantSiPMRaw", {size::geant_deposits}, true);
+        cat_mgr.register_category(SabatCategories::EventHeader, "EventHeader", {1}, false);
+        cat_mgr.register_category(SabatCategories::SiPMRaw, "SiPMRaw", {size::modules, size::sipms}, false);
+        cat_mgr.register_category(SabatCategories::SiPMCal, "SiPMCal", {size::modules, size::sipms}, false);
+        cat_mgr.register_category(SabatCategories::PhotonHit, "PhotonHit", {size::modules, 10}, false);
+        cat_mgr.register_category(SabatCategories::SiPMTimeOrder, "SiPMTimeOrder", {128}, false);
+        cat_mgr.register_category(SabatCategories::CoincWindow, "CoincWindow", {128}, false);
     }
 
     auto setup_containers(spark::database& rundb) -> void override
     {
         rundb.register_container<SabatLookup>("SabatLookup", 0x0000, 0x1000, 64, "{:x} {}", "{} {}");
         rundb.register_container<SiPMCalPar>("SiPMCalPar", "{:x} {}", "{} {} {}");
+        rundb.register_container<SiPMCoincPar>("SiPMCoincPar", "{}", "{}");
+        rundb.register_container<SabatGeometryPar>("SabatGeometryPar", "{:x} {}", "{} {} {} {}");
+        rundb.register_container<SiPMDigiPar>("SiPMDigiPar", "{}", "{} {} {} {} {} {}");
+        rundb.register_container<SabatChannelMask>("SabatChannelMask", "{}", "{:x}");
     }
 
     auto setup_tasks(spark::task_manager& task_mgr) -> void override
     {
-        task_mgr.add_task<sabat_calibration>();
-        task_mgr.add_task<sabat_clustering, sabat_calibration>();
+        if (setup.task_threads > 1) {
+            task_mgr.add_task<sabat_task_dag>(setup.task_threads, [this](auto& nodes) { add_tasks(nodes); });
+            return;
+        }
+
+        if (setup.sim_seed) {
+            task_mgr.add_task<sabat_digitization>(setup.demand, *setup.sim_seed);
+            task_mgr.add_task<sabat_calibration, sabat_digitization>(setup.demand);
+        } else {
+            task_mgr.add_task<sabat_calibration>(setup.demand);
+        }
+        task_mgr.add_task<sabat_clustering, sabat_calibration>(setup.demand);
+        task_mgr.add_task<sabat_time_sorting, sabat_calibration>(setup.demand);
+
+        if (setup.event_index) {
+            task_mgr.add_task<sabat_event_indexing, sabat_clustering>(setup.demand, *setup.event_index);
+        }
+        if (setup.dst_output) {
+            task_mgr.add_task<sabat_dst_writer>(setup.demand, *setup.dst_output);
+        }
+        if (setup.columnar_output) {
+            task_mgr.add_task<sabat_columnar_writer, sabat_clustering>(setup.demand, *setup.columnar_output);
+        }
+        // before the monitor and the hot channels, so their state saved at a checkpoint excludes the event
+        if (setup.checkpoint) {
+            task_mgr.add_task<sabat_checkpointing>(*setup.checkpoint,
+                                                   setup.event_index ? &*setup.event_index : nullptr);
+        }
+        if (setup.monitor) {
+            task_mgr.add_task<sabat_monitoring>(setup.demand, *setup.monitor);
+        }
+        if (setup.hot_channels) {
+            task_mgr.add_task<sabat_hot_channel_detection>(setup.demand, *setup.hot_channels);
+        }
     }
+
+private:
+    /// Tasks in the order of execution, the graph derives their dependencies from their categories.
+    template<typename Nodes>
+    auto add_tasks(Nodes& nodes) -> void
+    {
+        if (setup.sim_seed) {
+            nodes.template add<sabat_digitization>(setup.demand, *setup.sim_seed);
+        }
+        nodes.template add<sabat_calibration>(setup.demand);
+        nodes.template add<sabat_clustering>(setup.demand);
+        nodes.template add<sabat_time_sorting>(setup.demand);
+
+        if (setup.event_index) {
+            nodes.template add<sabat_event_indexing>(setup.demand, *setup.event_index);
+        }
+        if (setup.dst_output) {
+            nodes.template add<sabat_dst_writer>(setup.demand, *setup.dst_output);
+        }
+        if (setup.columnar_output) {
+            nodes.template add<sabat_columnar_writer>(setup.demand, *setup.columnar_output);
+        }
+        // before the monitor and the hot channels, so their state saved at a checkpoint excludes the event
+        if (setup.checkpoint) {
+            nodes.template add<sabat_checkpointing>(*setup.checkpoint,
+                                                    setup.event_index ? &*setup.event_index : nullptr);
+        }
+        if (setup.monitor) {
+            nodes.template add<sabat_monitoring>(setup.demand, *setup.monitor);
+        }
+        if (setup.hot_channels) {
+            nodes.template add<sabat_hot_channel_detection>(setup.demand, *setup.hot_channels);
+        }
+    }
+
+    sabat::processing_setup& setup;
 };
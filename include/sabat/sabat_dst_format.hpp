@@ -0,0 +1,501 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/citiroc_types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+/**
+ * Compact SABAT DST format of the SiPMRaw data.
+ *
+ * File: magic, format version and the Citiroc file header of the source file, followed by the event frames.
+ * Event frame: varint payload size, payload. Payload: event header (since version 2), varint number of hits, hits.
+ * Event header: varints board, trigger timestamp, trigger id, channel mask, flags. All are absolute values, the
+ * trigger timestamp is not a delta to the previous event, so each frame decodes on its own (e.g. after a seek).
+ * Hit: varint key (flags | channel << 7 | board << 15), then present fields in order: zigzag sipm - channel, zigzag
+ * LG PHA, zigzag HG PHA, ToA, ToT. ToA and ToT are stored in units of 0.5 ns (as read by the Citiroc), ToA as zigzag
+ * delta to the previous ToA in the event. Values which are not multiple of 0.5 ns are stored as raw floats, as is
+ * -0.0, so the round trip is bit exact. Zero-valued fields are not stored. The channel must be in 0-255 and the board
+ * non-negative.
+ *
+ * Fixed size integers and floats are little-endian.
+ */
+namespace sabat::dst
+{
+
+inline constexpr std::array<char, 8> magic {'S', 'A', 'B', 'A', 'T', 'D', 'S', 'T'};
+inline constexpr uint16_t format_version {2};
+inline constexpr uint16_t min_format_version {1};
+
+struct raw_hit
+{
+    int board {-1};
+    int channel {-1};
+    int sipm {-1};
+    float toa {0};
+    float tot {0};
+    int lgpha {0};
+    int hgpha {0};
+
+    auto operator==(const raw_hit&) const -> bool = default;
+};
+
+namespace flags
+{
+constexpr uint8_t sipm {0x01};
+constexpr uint8_t lgpha {0x02};
+constexpr uint8_t hgpha {0x04};
+constexpr uint8_t toa {0x08};
+constexpr uint8_t tot {0x10};
+constexpr uint8_t toa_float {0x20};
+constexpr uint8_t tot_float {0x40};
+constexpr unsigned bits {7};
+}  // namespace flags
+
+inline constexpr float time_lsb {0.5};
+
+/// Convert between the host and the little-endian byte order of the files.
+template<typename T>
+constexpr auto little_endian(T v) -> T
+{
+    if constexpr (std::endian::native == std::endian::big and sizeof(T) > 1) {
+        return std::byteswap(v);
+    } else {
+        return v;
+    }
+}
+
+constexpr auto zigzag(int64_t v) -> uint64_t
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+constexpr auto unzigzag(uint64_t v) -> int64_t
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline auto append_varint(std::vector<std::byte>& out, uint64_t v) -> void
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::byte>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(v));
+}
+
+/// Decode varint from buffer and advance, returns false if the buffer ends before the varint.
+inline auto read_varint(const std::byte*& p, const std::byte* end, uint64_t& v) -> bool
+{
+    v = 0;
+    for (unsigned shift = 0; p != end and shift < 64; shift += 7) {
+        auto byte = std::to_integer<uint64_t>(*p++);
+        v |= (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline auto read_varint(std::istream& source) -> std::optional<uint64_t>
+{
+    uint64_t v {0};
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        auto byte = source.get();
+        if (byte == std::istream::traits_type::eof()) {
+            return std::nullopt;
+        }
+        v |= (static_cast<uint64_t>(byte) & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return v;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Read the size of the next event frame. The size varint and the frame must fit in the \p remaining bytes of the
+ * file, which are reduced by both, so a corrupted size is never used to allocate the payload.
+ *
+ * \return frame size, nullopt at the end of the file, for a cut size or a frame past the end of the file
+ */
+inline auto read_frame_size(std::istream& source, uint64_t& remaining) -> std::optional<uint64_t>
+{
+    uint64_t v {0};
+    for (unsigned shift = 0; shift < 64 and remaining > 0; shift += 7) {
+        auto byte = source.get();
+        if (byte == std::istream::traits_type::eof()) {
+            return std::nullopt;
+        }
+        --remaining;
+        v |= (static_cast<uint64_t>(byte) & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            if (v > remaining) {
+                return std::nullopt;
+            }
+            remaining -= v;
+            return v;
+        }
+    }
+    return std::nullopt;
+}
+
+/// Time in units of 0.5 ns if the value is exactly representable as such, -0.0 is not.
+inline auto to_lsb(float t) -> std::optional<int64_t>
+{
+    if (!std::isfinite(t) or std::abs(t) > 1e15f) {
+        return std::nullopt;
+    }
+    auto lsb = std::llround(static_cast<double>(t) / time_lsb);
+    if (std::bit_cast<uint32_t>(static_cast<float>(lsb * time_lsb)) != std::bit_cast<uint32_t>(t)) {
+        return std::nullopt;
+    }
+    return lsb;
+}
+
+inline auto from_lsb(int64_t lsb) -> float
+{
+    return static_cast<float>(lsb * time_lsb);
+}
+
+inline auto append_float(std::vector<std::byte>& out, float v) -> void
+{
+    auto bits = std::bit_cast<std::array<std::byte, sizeof(float)>>(little_endian(std::bit_cast<uint32_t>(v)));
+    out.insert(out.end(), bits.begin(), bits.end());
+}
+
+/// Decode float from buffer and advance, returns false if the buffer ends before the float.
+inline auto read_float(const std::byte*& p, const std::byte* end, float& v) -> bool
+{
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(float))) {
+        return false;
+    }
+    std::array<std::byte, sizeof(float)> bits {};
+    std::copy_n(p, sizeof(float), bits.begin());
+    v = std::bit_cast<float>(little_endian(std::bit_cast<uint32_t>(bits)));
+    p += sizeof(float);
+    return true;
+}
+
+/// Hit can be stored in the key of the format.
+constexpr auto is_storable(const raw_hit& hit) -> bool
+{
+    return hit.channel >= 0 and hit.channel <= 0xff and hit.board >= 0;
+}
+
+/// Encode event payload, appended to out. Returns false if a hit is not storable, out is incomplete then.
+inline auto encode_event(std::span<const raw_hit> hits, std::vector<std::byte>& out) -> bool
+{
+    append_varint(out, hits.size());
+
+    int64_t prev_toa {0};
+
+    for (const auto& hit : hits) {
+        if (!is_storable(hit)) {
+            return false;
+        }
+
+        uint8_t hit_flags {0};
+
+        std::optional<int64_t> toa_lsb;
+        std::optional<int64_t> tot_lsb;
+
+        if (hit.sipm != hit.channel) {
+            hit_flags |= flags::sipm;
+        }
+        if (hit.lgpha != 0) {
+            hit_flags |= flags::lgpha;
+        }
+        if (hit.hgpha != 0) {
+            hit_flags |= flags::hgpha;
+        }
+        if (std::bit_cast<uint32_t>(hit.toa) != 0) {  // +0.0 only
+            toa_lsb = to_lsb(hit.toa);
+            hit_flags |= toa_lsb ? flags::toa : flags::toa_float;
+        }
+        if (std::bit_cast<uint32_t>(hit.tot) != 0) {
+            tot_lsb = to_lsb(hit.tot);
+            hit_flags |= tot_lsb ? flags::tot : flags::tot_float;
+        }
+
+        append_varint(out,
+                      hit_flags | (static_cast<uint64_t>(hit.channel) << flags::bits)
+                          | (static_cast<uint64_t>(hit.board) << (flags::bits + 8)));
+
+        if (hit_flags & flags::sipm) {
+            append_varint(out, zigzag(hit.sipm - hit.channel));
+        }
+        if (hit_flags & flags::lgpha) {
+            append_varint(out, zigzag(hit.lgpha));
+        }
+        if (hit_flags & flags::hgpha) {
+            append_varint(out, zigzag(hit.hgpha));
+        }
+        if (hit_flags & flags::toa) {
+            append_varint(out, zigzag(*toa_lsb - prev_toa));
+            prev_toa = *toa_lsb;
+        } else if (hit_flags & flags::toa_float) {
+            append_float(out, hit.toa);
+        }
+        if (hit_flags & flags::tot) {
+            append_varint(out, zigzag(*tot_lsb));
+        } else if (hit_flags & flags::tot_float) {
+            append_float(out, hit.tot);
+        }
+    }
+
+    return true;
+}
+
+/// Encode event header, appended to out.
+inline auto encode_header(const spark::citiroc::types::event_header& header, std::vector<std::byte>& out) -> void
+{
+    append_varint(out, header.brd);
+    append_varint(out, header.trgts);
+    append_varint(out, header.trgid);
+    append_varint(out, header.chmask);
+    append_varint(out, header.flags);
+}
+
+/// Decode event header and advance, returns false if the buffer ends before the header.
+inline auto decode_header(const std::byte*& p, const std::byte* end, spark::citiroc::types::event_header& header)
+    -> bool
+{
+    uint64_t brd {0};
+    uint64_t flags {0};
+
+    if (!read_varint(p, end, brd) or !read_varint(p, end, header.trgts) or !read_varint(p, end, header.trgid)
+        or !read_varint(p, end, header.chmask) or !read_varint(p, end, flags))
+    {
+        return false;
+    }
+
+    header.brd = static_cast<uint8_t>(brd);
+    header.flags = static_cast<uint16_t>(flags);
+
+    return true;
+}
+
+/**
+ * Decode event payload (hits part). The callback is called for each hit.
+ *
+ * \return false if the payload is malformed
+ */
+template<typename Callback>
+auto decode_event(std::span<const std::byte> payload, Callback&& callback) -> bool
+{
+    const auto* p = payload.data();
+    const auto* end = p + payload.size();
+
+    uint64_t n_hits {0};
+    if (!read_varint(p, end, n_hits)) {
+        return false;
+    }
+
+    int64_t prev_toa {0};
+
+    for (uint64_t i = 0; i < n_hits; ++i) {
+        uint64_t key {0};
+        if (!read_varint(p, end, key)) {
+            return false;
+        }
+
+        const auto hit_flags = static_cast<uint8_t>(key & ((1u << flags::bits) - 1));
+
+        raw_hit hit;
+        hit.channel = static_cast<int>((key >> flags::bits) & 0xff);
+        hit.board = static_cast<int>(key >> (flags::bits + 8));
+        hit.sipm = hit.channel;
+
+        uint64_t v {0};
+
+        if (hit_flags & flags::sipm) {
+            if (!read_varint(p, end, v)) {
+                return false;
+            }
+            hit.sipm = static_cast<int>(hit.channel + unzigzag(v));
+        }
+        if (hit_flags & flags::lgpha) {
+            if (!read_varint(p, end, v)) {
+                return false;
+            }
+            hit.lgpha = static_cast<int>(unzigzag(v));
+        }
+        if (hit_flags & flags::hgpha) {
+            if (!read_varint(p, end, v)) {
+                return false;
+            }
+            hit.hgpha = static_cast<int>(unzigzag(v));
+        }
+        if (hit_flags & flags::toa) {
+            if (!read_varint(p, end, v)) {
+                return false;
+            }
+            prev_toa += unzigzag(v);
+            hit.toa = from_lsb(prev_toa);
+        } else if (hit_flags & flags::toa_float) {
+            if (!read_float(p, end, hit.toa)) {
+                return false;
+            }
+        }
+        if (hit_flags & flags::tot) {
+            if (!read_varint(p, end, v)) {
+                return false;
+            }
+            hit.tot = from_lsb(unzigzag(v));
+        } else if (hit_flags & flags::tot_float) {
+            if (!read_float(p, end, hit.tot)) {
+                return false;
+            }
+        }
+
+        callback(hit);
+    }
+
+    return p == end;
+}
+
+template<typename T>
+auto write_le(std::ostream& out, T v) -> void
+{
+    v = little_endian(v);
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template<typename T>
+auto read_le(std::istream& in) -> T
+{
+    T v {};
+    in.read(reinterpret_cast<char*>(&v), sizeof(T));
+    return little_endian(v);
+}
+
+inline auto write_file_header(std::ostream& out, const spark::citiroc::types::file_header& fheader) -> void
+{
+    out.write(magic.data(), magic.size());
+    write_le(out, format_version);
+
+    write_le(out, fheader.firmware_ver);
+    write_le(out, fheader.janus_rel);
+    write_le(out, fheader.board_id);
+    write_le(out, fheader.run);
+    write_le(out, fheader.acq_mode);
+    write_le(out, fheader.e_hists_nbins);
+    write_le(out, fheader.toa_tot_unit);
+    write_le(out, fheader.time_lsb);
+    write_le(out, fheader.run_timestamp);
+}
+
+/**
+ * Read the file header.
+ *
+ * \param version set to the format version of the file
+ */
+inline auto read_file_header(std::istream& in, uint16_t& version) -> std::optional<spark::citiroc::types::file_header>
+{
+    std::array<char, magic.size()> file_magic {};
+    in.read(file_magic.data(), file_magic.size());
+
+    if (!in or file_magic != magic) {
+        return std::nullopt;
+    }
+
+    version = read_le<uint16_t>(in);
+    if (version < min_format_version or version > format_version) {
+        return std::nullopt;
+    }
+
+    spark::citiroc::types::file_header fheader;
+    fheader.firmware_ver = read_le<uint16_t>(in);
+    fheader.janus_rel = read_le<uint32_t>(in);
+    fheader.board_id = read_le<uint16_t>(in);
+    fheader.run = read_le<uint16_t>(in);
+    fheader.acq_mode = read_le<uint8_t>(in);
+    fheader.e_hists_nbins = read_le<uint16_t>(in);
+    fheader.toa_tot_unit = read_le<uint8_t>(in);
+    fheader.time_lsb = read_le<uint32_t>(in);
+    fheader.run_timestamp = read_le<uint64_t>(in);
+
+    if (!in) {
+        return std::nullopt;
+    }
+
+    return fheader;
+}
+
+/**
+ * Streaming writer of the compact DST file.
+ */
+class dst_writer
+{
+public:
+    auto open(const std::filesystem::path& filepath, const spark::citiroc::types::file_header& fheader) -> bool
+    {
+        close();
+
+        out = std::ofstream(filepath, std::ios_base::binary);
+        if (!out) {
+            return false;
+        }
+
+        write_file_header(out, fheader);
+        return static_cast<bool>(out);
+    }
+
+    /// Close the file, returns false if any write failed.
+    auto close() -> bool
+    {
+        if (!out.is_open()) {
+            return true;
+        }
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+    auto is_open() const -> bool { return out.is_open(); }
+
+    /// Write the event, returns false on write error or if a hit is not storable.
+    auto write_event(const spark::citiroc::types::event_header& header, std::span<const raw_hit> hits) -> bool
+    {
+        payload.clear();
+        encode_header(header, payload);
+        if (!encode_event(hits, payload)) {
+            return false;
+        }
+
+        frame.clear();
+        append_varint(frame, payload.size());
+
+        out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+        out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+
+        return static_cast<bool>(out);
+    }
+
+private:
+    std::ofstream out;
+    std::vector<std::byte> frame;
+    std::vector<std::byte> payload;
+};
+
+}  // namespace sabat::dst
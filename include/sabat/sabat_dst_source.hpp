@@ -0,0 +1,231 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include "sabat/citiroc_types.hpp"
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_dst_format.hpp"
+
+#include <spark/core/data_source.hpp>
+#include <spark/core/unpacker.hpp>
+#include <spark/spark.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace sabat::dst
+{
+
+/**
+ * Extends data_source to read the compact SABAT DST files.
+ */
+class SABAT_EXPORT dst_source : public spark::data_source
+{
+public:
+    dst_source() = default;
+
+    auto read_current_event() -> bool override;
+
+    /**
+     * Set input for the source. If another file is already open, it is closed first.
+     *
+     * \param filename input file name
+     */
+    auto set_input(const std::filesystem::path& filepath) -> void
+    {
+        close();
+        file = filepath;
+    }
+
+    auto open() -> bool override;
+
+    auto close() -> bool override;
+
+    auto header() const -> const spark::citiroc::types::file_header* { return &fheader; }
+
+private:
+    std::filesystem::path file;  ///< file name
+
+    std::ifstream source;                        ///< input file stream
+    spark::citiroc::types::file_header fheader;  ///< header of the original Citiroc file
+    uint16_t version {0};                        ///< format version of the file
+    uint64_t remaining {0};                      ///< bytes of the file not read yet
+    bool is_open {false};
+};
+
+/**
+ * Unpacks the DST event frames into EventHeader and SiPMRaw. Files of format version 1 have no event header, only the
+ * number of hits is set then. The number of hits counts all hits of the frame, hits outside the SiPMRaw category
+ * (module or SiPM out of range) are dropped with a warning.
+ *
+ * \tparam Category spark::category, or a type with the same object interface
+ */
+template<typename Category>
+class frame_unpacker
+{
+public:
+    frame_unpacker(Category& cat_event_header, Category& cat_sipm_raw)
+        : cat_event_header(cat_event_header)
+        , cat_sipm_raw(cat_sipm_raw)
+    {
+    }
+
+    auto set_format_version(uint16_t file_version) -> void { version = file_version; }
+
+    /// Read and unpack a frame of the given size, false if the frame is cut short or malformed.
+    auto read_frame(std::istream& source, size_t length) -> bool
+    {
+        payload.resize(length);
+        source.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(length));
+
+        if (!source) {
+            return false;
+        }
+
+        spark::citiroc::types::event_header header;
+        std::span<const std::byte> hits_payload {payload};
+
+        if (version >= 2) {
+            const auto* p = payload.data();
+            if (!decode_header(p, payload.data() + payload.size(), header)) {
+                spdlog::error("[{}] Malformed DST event header", __PRETTY_FUNCTION__);
+                return false;
+            }
+            hits_payload = hits_payload.subspan(static_cast<size_t>(p - payload.data()));
+        }
+
+        int n_dropped {0};
+
+        auto ok = decode_event(hits_payload,
+                               [&](const raw_hit& hit)
+                               {
+                                   header.nhits++;
+
+                                   if (static_cast<size_t>(hit.board) >= category_size::modules
+                                       or static_cast<size_t>(hit.sipm) >= category_size::sipms)
+                                   {
+                                       n_dropped++;
+                                       return;
+                                   }
+
+                                   const auto board = static_cast<size_t>(hit.board);
+                                   const auto sipm = static_cast<size_t>(hit.sipm);
+
+                                   auto obj = cat_sipm_raw.template get_object<SiPMRaw>({board, sipm});
+                                   if (!obj) {
+                                       obj = cat_sipm_raw.template make_object_unsafe<SiPMRaw>({board, sipm});
+                                   }
+
+                                   obj->board = hit.board;
+                                   obj->channel = hit.channel;
+                                   obj->sipm = hit.sipm;
+                                   obj->toa = hit.toa;
+                                   obj->tot = hit.tot;
+                                   obj->lgpha = hit.lgpha;
+                                   obj->hgpha = hit.hgpha;
+                               });
+
+        if (!ok) {
+            spdlog::error("[{}] Malformed DST event", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        if (n_dropped > 0) {
+            spdlog::warn("[{}] Dropped {} of {} hits of trigger {} outside the SiPMRaw category",
+                         __PRETTY_FUNCTION__,
+                         n_dropped,
+                         header.nhits,
+                         header.trgid);
+        }
+
+        auto hdr_obj = cat_event_header.template make_object_unsafe<EventHeader>({0});
+        hdr_obj->board = header.brd;
+        hdr_obj->trgts = header.trgts;
+        hdr_obj->trgid = header.trgid;
+        hdr_obj->chmask = header.chmask;
+        hdr_obj->flags = header.flags;
+        hdr_obj->nhits = header.nhits;
+
+        return true;
+    }
+
+private:
+    Category& cat_event_header;
+    Category& cat_sipm_raw;
+    uint16_t version {format_version};
+    std::vector<std::byte> payload;
+};
+
+/**
+ * Fills EventHeader and SiPMRaw from the compact DST event frames with frame_unpacker.
+ */
+class SABAT_EXPORT dst_unpacker : public spark::unpacker
+{
+public:
+    using unpacker::unpacker;
+
+    auto init() -> bool override
+    {
+        unpacker::init();
+
+        cat_sipm_raw = model()->template build_category<SiPMRaw>(SabatCategories::SiPMRaw);
+
+        if (cat_sipm_raw == nullptr) {
+            spdlog::critical("[{}] No SiPMRaw category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_event_header = model()->template build_category<EventHeader>(SabatCategories::EventHeader);
+
+        if (cat_event_header == nullptr) {
+            spdlog::critical("[{}] No EventHeader category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        reader.emplace(*cat_event_header, *cat_sipm_raw);
+        reader->set_format_version(version);
+
+        return true;
+    }
+
+    auto set_format_version(uint16_t file_version) -> void
+    {
+        version = file_version;
+        if (reader) {
+            reader->set_format_version(version);
+        }
+    }
+
+    auto execute(uint64_t /*event*/,
+                 uint64_t /*seq_number*/,
+                 uint16_t /*subevent*/,
+                 std::istream& source,
+                 size_t length) -> bool override
+    {
+        return reader->read_frame(source, length);
+    }
+
+private:
+    spark::category* cat_sipm_raw {nullptr};
+    spark::category* cat_event_header {nullptr};
+    uint16_t version {format_version};
+    std::optional<frame_unpacker<spark::category>> reader;
+};
+
+}  // namespace sabat::dst
@@ -0,0 +1,83 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+class TEntryList;
+
+namespace sabat
+{
+
+inline constexpr std::string_view event_index_tree {"EventIndex"};
+
+/// Index record of the output tree entry with the same number.
+struct event_index_record
+{
+    uint64_t trgts {0};         ///< trigger timestamp
+    uint32_t multiplicity {0};  ///< number of SiPMRaw hits
+    float energy {0};           ///< sum of PhotonHit energies, NaN if PhotonHit was not reconstructed
+};
+
+/// Selection of the entries, unset limits are not checked. Ranges are inclusive.
+struct event_selection
+{
+    std::optional<uint64_t> t_min;
+    std::optional<uint64_t> t_max;
+    std::optional<float> e_min;
+    std::optional<float> e_max;
+    std::optional<uint32_t> mult_min;
+
+    auto accepts(const event_index_record& rec) const -> bool
+    {
+        return (!t_min or rec.trgts >= *t_min) and (!t_max or rec.trgts <= *t_max) and (!e_min or rec.energy >= *e_min)
+               and (!e_max or rec.energy <= *e_max) and (!mult_min or rec.multiplicity >= *mult_min);
+    }
+};
+
+/**
+ * Write the index records as the EventIndex tree into the closed output file.
+ */
+SABAT_EXPORT auto write_event_index(const std::filesystem::path& filepath, std::span<const event_index_record> records)
+    -> bool;
+
+/**
+ * Event index of an output file. The index is read into memory, so the selections do not touch the event tree.
+ */
+class SABAT_EXPORT event_index
+{
+public:
+    auto open(const std::filesystem::path& filepath) -> bool;
+
+    auto size() const -> size_t { return records.size(); }
+
+    auto record(size_t entry) const -> const event_index_record& { return records[entry]; }
+
+    /// Entries of the event tree matching the selection, in increasing order.
+    auto select(const event_selection& selection) const -> std::vector<int64_t>;
+
+    /// Entry list of the matching entries, to be set on the event tree with TTree::SetEntryList.
+    auto make_entry_list(const event_selection& selection, std::string_view tree_name = "T") const
+        -> std::unique_ptr<TEntryList>;
+
+private:
+    std::filesystem::path file;
+    std::vector<event_index_record> records;
+};
+
+}  // namespace sabat
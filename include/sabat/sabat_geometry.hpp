@@ -0,0 +1,271 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_parameters.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+
+namespace sabat
+{
+
+namespace units
+{
+constexpr float mm = 1e-1;
+constexpr float cm = 1e+0;
+}  // namespace units
+
+struct channel_position
+{
+    float x {0};
+    float y {0};
+    float z {0};
+};
+
+namespace detail
+{
+/// Channel to pixel map of the SiPM matrix (board 0), the corner pixels of the 8x8 matrix are not connected.
+inline constexpr std::array<uint8_t, 52> sipm_pixel_map {2,  3,  4,  5,  9,  10, 11, 12, 13, 14, 16, 17, 18,
+                                                         19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+                                                         32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+                                                         45, 46, 47, 49, 50, 51, 52, 53, 54, 58, 59, 60, 61};
+
+/// BGO crystals read out by each channel of board 1, -1 marks unused slot.
+inline constexpr std::array<std::array<int8_t, 3>, 13> bgo_crystal_map {{
+    {0, 1, -1},
+    {2, 3, -1},
+    {4, 5, -1},
+    {6, 7, 8},
+    {9, 10, -1},
+    {11, 12, -1},
+    {13, 14, -1},
+    {15, 16, -1},
+    {17, 18, -1},
+    {19, 20, -1},
+    {21, 22, 23},
+    {24, 25, -1},
+    {26, 27, -1},
+}};
+}  // namespace detail
+
+/**
+ * Channel map and geometry of the SABAT detector.
+ *
+ * Gives channel -> pixel -> position and neighbour queries in constant time. The defaults are built at compile time
+ * (see default_geometry), the positions can be overridden from the SabatGeometryPar container with apply(), see also
+ * load_geometry().
+ *
+ * Board 0 is the SiPM matrix of 8x8 pixels, board 1 reads out the BGO crystals in clusters. The BGO positions are not
+ * known without the parameters, therefore board 1 channels are not placed by default and have no neighbours.
+ */
+class detector_geometry
+{
+public:
+    static constexpr size_t max_boards {2};
+    static constexpr size_t max_channels {64};
+    static constexpr size_t max_neighbours {8};
+
+    static constexpr int sipm_board {0};
+    static constexpr int bgo_board {1};
+
+    static constexpr int sipm_matrix_size {8};
+    static constexpr float sipm_pitch {6.0 * units::mm};
+    static constexpr float bgo_pitch {6.0 * units::mm};
+    static constexpr size_t n_bgo_crystals {28};
+
+    constexpr detector_geometry()
+    {
+        for (auto& board_pixels : pixels) {
+            board_pixels.fill(-1);
+        }
+
+        n_chans[sipm_board] = detail::sipm_pixel_map.size();
+        neighbour_distance[sipm_board] = 1.5f * sipm_pitch;  // includes the diagonal pixels
+
+        for (size_t ch = 0; ch < detail::sipm_pixel_map.size(); ++ch) {
+            const int pixel = detail::sipm_pixel_map[ch];
+            const auto col = static_cast<float>(pixel % sipm_matrix_size);
+            const auto row = static_cast<float>(pixel / sipm_matrix_size);
+            constexpr float center = (sipm_matrix_size - 1) / 2.0f;
+
+            set_channel(sipm_board,
+                        ch,
+                        pixel,
+                        channel_position {(col - center) * sipm_pitch, (row - center) * sipm_pitch, 0});
+        }
+
+        n_chans[bgo_board] = detail::bgo_crystal_map.size();
+        for (size_t ch = 0; ch < detail::bgo_crystal_map.size(); ++ch) {
+            set_channel(bgo_board, ch, static_cast<int>(ch), std::nullopt);
+        }
+
+        update_neighbours();
+    }
+
+    /**
+     * Override the defaults with the parameter container. Only the channels having a row (pixel, x, y, z) in the
+     * container are changed, the neighbours are recalculated afterwards.
+     *
+     * \param par geometry container (wrapper) keyed with (board, channel)
+     */
+    template<typename ContainerWrapper>
+    auto apply(ContainerWrapper& par) -> void
+    {
+        for (size_t board = 0; board < max_boards; ++board) {
+            for (size_t ch = 0; ch < max_channels; ++ch) {
+                auto row = find_row(par, static_cast<uint8_t>(board), static_cast<uint8_t>(ch));
+                if (!row) {
+                    continue;
+                }
+
+                auto [pixel, x, y, z] = *row;
+                set_channel(board, ch, pixel, channel_position {x, y, z});
+                n_chans[board] = std::max<size_t>(n_chans[board], ch + 1);
+                if (board == bgo_board) {
+                    neighbour_distance[board] = 1.5f * bgo_pitch;
+                }
+            }
+        }
+
+        update_neighbours();
+    }
+
+    constexpr auto n_channels(int board) const -> int { return valid(board, 0) ? n_chans[board] : 0; }
+
+    constexpr auto pixel(int board, int channel) const -> int
+    {
+        return valid(board, channel) ? channels[board][channel].pixel : -1;
+    }
+
+    constexpr auto channel(int board, int pixel) const -> int
+    {
+        return valid(board, pixel) ? pixels[board][pixel] : -1;
+    }
+
+    constexpr auto position(int board, int channel) const -> const channel_position&
+    {
+        return valid(board, channel) ? channels[board][channel].pos : no_position;
+    }
+
+    /// Channels neighbouring the given channel on the same board.
+    constexpr auto neighbours(int board, int channel) const -> std::span<const uint8_t>
+    {
+        if (!valid(board, channel)) {
+            return {};
+        }
+        const auto& entry = channels[board][channel];
+        return {entry.neighbours.data(), entry.n_neighbours};
+    }
+
+    /// BGO crystals read out by the given board 1 channel.
+    constexpr auto bgo_crystals(int channel) const -> std::span<const int8_t>
+    {
+        if (channel < 0 or static_cast<size_t>(channel) >= detail::bgo_crystal_map.size()) {
+            return {};
+        }
+        const auto& crystals = detail::bgo_crystal_map[channel];
+        size_t n = 0;
+        while (n < crystals.size() and crystals[n] >= 0) {
+            ++n;
+        }
+        return {crystals.data(), n};
+    }
+
+private:
+    struct channel_entry
+    {
+        int16_t pixel {-1};
+        channel_position pos {};
+        bool placed {false};
+        std::array<uint8_t, max_neighbours> neighbours {};
+        uint8_t n_neighbours {0};
+    };
+
+    static constexpr auto valid(int board, int idx) -> bool
+    {
+        return board >= 0 and static_cast<size_t>(board) < max_boards and idx >= 0
+            and static_cast<size_t>(idx) < max_channels;
+    }
+
+    constexpr auto set_channel(size_t board, size_t ch, int pixel, std::optional<channel_position> pos) -> void
+    {
+        auto& entry = channels[board][ch];
+        if (entry.pixel >= 0) {
+            pixels[board][entry.pixel] = -1;
+        }
+
+        entry.pixel = static_cast<int16_t>(pixel);
+        entry.pos = pos.value_or(channel_position {});
+        entry.placed = pos.has_value();
+        if (valid(static_cast<int>(board), pixel)) {
+            pixels[board][pixel] = static_cast<int16_t>(ch);
+        }
+    }
+
+    constexpr auto update_neighbours() -> void
+    {
+        for (size_t board = 0; board < max_boards; ++board) {
+            const auto dist2 = neighbour_distance[board] * neighbour_distance[board];
+
+            for (size_t ch = 0; ch < n_chans[board]; ++ch) {
+                auto& entry = channels[board][ch];
+                entry.n_neighbours = 0;
+
+                if (!entry.placed) {
+                    continue;
+                }
+
+                for (size_t other = 0; other < n_chans[board] and entry.n_neighbours < max_neighbours; ++other) {
+                    if (other == ch or !channels[board][other].placed) {
+                        continue;
+                    }
+
+                    const auto& p = channels[board][other].pos;
+                    const auto dx = p.x - entry.pos.x;
+                    const auto dy = p.y - entry.pos.y;
+                    const auto dz = p.z - entry.pos.z;
+
+                    if (dx * dx + dy * dy + dz * dz <= dist2) {
+                        entry.neighbours[entry.n_neighbours++] = static_cast<uint8_t>(other);
+                    }
+                }
+            }
+        }
+    }
+
+    static constexpr channel_position no_position {};
+
+    std::array<std::array<channel_entry, max_channels>, max_boards> channels {};
+    std::array<std::array<int16_t, max_channels>, max_boards> pixels {};
+    std::array<size_t, max_boards> n_chans {};
+    std::array<float, max_boards> neighbour_distance {};
+};
+
+/// Compile time default geometry.
+inline constexpr detector_geometry default_geometry {};
+
+/// Default geometry with the overrides of the SabatGeometryPar container, if the parameters define it.
+template<typename Database>
+auto load_geometry(Database& db) -> detector_geometry
+{
+    auto geometry = default_geometry;
+    if (auto par = find_container<SabatGeometryPar>(db, "SabatGeometryPar")) {
+        geometry.apply(*par);
+    }
+    return geometry;
+}
+
+}  // namespace sabat
@@ -0,0 +1,286 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace sabat
+{
+
+/**
+ * Online detection of hot channels. The hits per channel are counted over a sliding window of the last n_blocks blocks
+ * of block_events events. Each time a block is completed, channels of a board with more than factor times the median
+ * count of the board's channels (and at least min_hits) are flagged. A channel flagged in at least min_fraction of the
+ * evaluated windows is hot.
+ *
+ * The boards are the hardware boards of the events (0-255), counted from their first hit. The suggested mask is the
+ * mask in use (its channels have no hits) extended with the hot channels.
+ */
+class hot_channel_detector
+{
+public:
+    static constexpr size_t n_boards {256};
+    static constexpr size_t n_channels {64};
+
+    explicit hot_channel_detector(uint32_t block_events = 1000,
+                                  size_t n_blocks = 10,
+                                  double factor = 10.,
+                                  uint32_t min_hits = 100,
+                                  double min_fraction = 0.5)
+        : block_events(std::max<uint32_t>(block_events, 1))
+        , n_blocks(std::max<size_t>(n_blocks, 1))
+        , factor(factor)
+        , min_hits(min_hits)
+        , min_fraction(min_fraction)
+    {
+    }
+
+    /// Start a new output, the masks in use are kept.
+    auto reset() -> void
+    {
+        std::erase_if(boards, [](const auto& b) { return b.second.base_mask == 0; });
+        for (auto& [b, state] : boards) {
+            state = {.blocks = std::vector<counts>(n_blocks), .base_mask = state.base_mask};
+        }
+        current = 0;
+        filled = 0;
+        events = 0;
+    }
+
+    /// Mask in use for the board, its channels are not evaluated.
+    auto set_base_mask(size_t board, uint64_t mask) -> void
+    {
+        if (board >= n_boards) {
+            return;
+        }
+        if (auto it = boards.find(board); it != boards.end()) {
+            it->second.base_mask = mask;
+        } else if (mask != 0) {
+            add_board(board).base_mask = mask;
+        }
+    }
+
+    auto add_hit(size_t board, size_t channel) -> void
+    {
+        if (board >= n_boards or channel >= n_channels) {
+            return;
+        }
+
+        auto it = boards.find(board);
+        auto& state = it != boards.end() ? it->second : add_board(board);
+        state.blocks[current][channel]++;
+        state.window[channel]++;
+    }
+
+    auto end_event() -> void
+    {
+        if (++events < block_events) {
+            return;
+        }
+
+        events = 0;
+        filled = std::min(filled + 1, n_blocks);
+
+        if (filled == n_blocks) {
+            evaluate();
+        }
+
+        current = (current + 1) % n_blocks;
+        for (auto& [b, state] : boards) {
+            for (size_t c = 0; c < n_channels; ++c) {
+                state.window[c] -= state.blocks[current][c];
+            }
+            state.blocks[current] = {};
+        }
+    }
+
+    /// Evaluate the partial window if the run was shorter than the window.
+    auto finish() -> void
+    {
+        if (filled < n_blocks and std::ranges::all_of(boards, [](auto& b) { return b.second.evaluations == 0; })) {
+            evaluate();
+        }
+    }
+
+    /// Boards with hits or with a mask in use, in increasing order.
+    auto board_list() const -> std::vector<size_t>
+    {
+        std::vector<size_t> list;
+        list.reserve(boards.size());
+        for (const auto& [b, state] : boards) {
+            list.push_back(b);
+        }
+        return list;
+    }
+
+    auto hot_mask(size_t board) const -> uint64_t
+    {
+        uint64_t mask {0};
+        auto it = boards.find(board);
+        if (it == boards.end() or it->second.evaluations == 0) {
+            return mask;
+        }
+
+        const auto& state = it->second;
+        for (size_t c = 0; c < n_channels; ++c) {
+            if (state.flagged[c] >= min_fraction * state.evaluations) {
+                mask |= uint64_t {1} << c;
+            }
+        }
+        return mask;
+    }
+
+    auto suggested_mask(size_t board) const -> uint64_t
+    {
+        auto it = boards.find(board);
+        return it == boards.end() ? 0 : it->second.base_mask | hot_mask(board);
+    }
+
+    /// Write the suggested masks of all boards with hits or a mask in use, in the SabatChannelMask parameter format.
+    auto write_mask(std::ostream& out) const -> void
+    {
+        out << "[SabatChannelMask]\n";
+        for (const auto& [b, state] : boards) {
+            out << fmt::format("{} {:x}\n", b, suggested_mask(b));
+        }
+    }
+
+    /// Write the whole state as text, to continue the detection with read_state() after a resume.
+    auto write_state(std::ostream& out) const -> void
+    {
+        out << n_blocks << ' ' << current << ' ' << filled << ' ' << events << ' ' << boards.size() << '\n';
+        for (const auto& [b, state] : boards) {
+            out << b << ' ' << state.evaluations << ' ' << state.base_mask << '\n';
+            write_counts(out, state.window);
+            write_counts(out, state.flagged);
+            for (const auto& block : state.blocks) {
+                write_counts(out, block);
+            }
+        }
+    }
+
+    /// Restore the state written by write_state() with the same number of blocks, false and a reset detector if it
+    /// is not valid. The masks in use are taken from the state.
+    auto read_state(std::istream& in) -> bool
+    {
+        boards.clear();
+        reset();
+
+        size_t saved_blocks {0};
+        size_t n_saved {0};
+        in >> saved_blocks >> current >> filled >> events >> n_saved;
+        bool valid = in and saved_blocks == n_blocks and current < n_blocks and filled <= n_blocks
+                     and events < block_events and n_saved <= n_boards;
+
+        for (size_t i = 0; valid and i < n_saved; ++i) {
+            size_t board {0};
+            board_state state {.blocks = std::vector<counts>(n_blocks)};
+            in >> board >> state.evaluations >> state.base_mask;
+            valid = in and board < n_boards and read_counts(in, state.window) and read_counts(in, state.flagged);
+            for (auto& block : state.blocks) {
+                valid = valid and read_counts(in, block);
+            }
+            valid = valid and boards.emplace(board, std::move(state)).second;
+        }
+
+        if (!valid) {
+            boards.clear();
+            reset();
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    using counts = std::array<uint32_t, n_channels>;
+
+    static auto write_counts(std::ostream& out, const counts& c) -> void
+    {
+        for (size_t i = 0; i < n_channels; ++i) {
+            out << (i == 0 ? "" : " ") << c[i];
+        }
+        out << '\n';
+    }
+
+    static auto read_counts(std::istream& in, counts& c) -> bool
+    {
+        for (auto& v : c) {
+            in >> v;
+        }
+        return static_cast<bool>(in);
+    }
+
+    struct board_state
+    {
+        std::vector<counts> blocks;  ///< ring of the counts per block
+        counts window {};            ///< counts of the blocks in the window
+        counts flagged {};           ///< evaluations where the channel was flagged
+        uint32_t evaluations {0};
+        uint64_t base_mask {0};
+    };
+
+    auto add_board(size_t board) -> board_state&
+    {
+        return boards.emplace(board, board_state {.blocks = std::vector<counts>(n_blocks)}).first->second;
+    }
+
+    auto evaluate() -> void
+    {
+        std::vector<uint32_t> rates;
+        rates.reserve(n_channels);
+
+        for (auto& [b, state] : boards) {
+            rates.clear();
+            for (size_t c = 0; c < n_channels; ++c) {
+                if ((state.base_mask >> c & 1u) == 0) {
+                    rates.push_back(state.window[c]);
+                }
+            }
+
+            if (rates.empty()) {
+                continue;
+            }
+
+            auto mid = rates.begin() + static_cast<std::ptrdiff_t>(rates.size() / 2);
+            std::ranges::nth_element(rates, mid);
+            const auto threshold = factor * std::max<double>(*mid, 1.);
+
+            for (size_t c = 0; c < n_channels; ++c) {
+                if ((state.base_mask >> c & 1u) == 0 and state.window[c] >= min_hits and state.window[c] > threshold) {
+                    state.flagged[c]++;
+                }
+            }
+
+            state.evaluations++;
+        }
+    }
+
+    uint32_t block_events;
+    size_t n_blocks;
+    double factor;
+    uint32_t min_hits;
+    double min_fraction;
+
+    std::map<size_t, board_state> boards;  ///< by hardware board
+    size_t current {0};
+    size_t filled {0};
+    uint32_t events {0};
+};
+
+}  // namespace sabat
@@ -0,0 +1,73 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+class TTree;
+
+namespace sabat
+{
+
+/**
+ * Storage settings of the output tree. Zero or negative values keep the ROOT defaults.
+ */
+struct SABAT_EXPORT output_options
+{
+    int compression_algorithm {0};  ///< ROOT::RCompressionSetting::EAlgorithm, 0 for the file default
+    int compression_level {-1};     ///< 0-9, negative for the file default
+    int32_t basket_size {0};        ///< basket buffer size in bytes
+    int64_t auto_flush {0};         ///< positive: entries, negative: bytes, between the flushes of the baskets
+    unsigned int io_threads {0};    ///< threads compressing the baskets at the flushes (ROOT implicit MT), 0 disabled
+
+    auto describe() const -> std::string;
+};
+
+/// Compression algorithm from its name: zlib, lzma, lz4, zstd.
+SABAT_EXPORT auto compression_algorithm_from_name(std::string_view name) -> std::optional<int>;
+
+/// Tree of the output file open for writing in this process, nullptr if not open.
+SABAT_EXPORT auto find_output_tree(const std::filesystem::path& filepath, std::string_view tree_name) -> TTree*;
+
+/**
+ * Apply the options to the tree of the open output file. The compression is set for the file and all existing branches,
+ * so it is effective for baskets written after the call. The tree uses implicit MT only with io_threads, which needs
+ * ROOT::EnableImplicitMT() of the process; the events are filled on the calling thread either way.
+ *
+ * \return false if the file or tree are not open
+ */
+SABAT_EXPORT auto apply_output_options(const std::filesystem::path& filepath,
+                                       std::string_view tree_name,
+                                       const output_options& opts) -> bool;
+
+/// Size summary of the written output.
+struct output_stats
+{
+    int64_t entries {0};
+    int64_t tot_bytes {0};  ///< uncompressed size of the tree
+    int64_t zip_bytes {0};  ///< compressed size of the tree
+    uintmax_t file_size {0};
+
+    auto compression_factor() const -> double
+    {
+        return zip_bytes > 0 ? static_cast<double>(tot_bytes) / static_cast<double>(zip_bytes) : 0.;
+    }
+};
+
+/// Read the summary of the closed output file.
+SABAT_EXPORT auto read_output_stats(const std::filesystem::path& filepath, std::string_view tree_name)
+    -> std::optional<output_stats>;
+
+}  // namespace sabat
@@ -0,0 +1,45 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/spark.hpp>
+
+#include <exception>
+#include <optional>
+#include <type_traits>
+
+namespace sabat
+{
+
+/**
+ * Container of optional parameters, nullopt if no parameter source defines it. The users of optional containers fall
+ * back to built-in defaults, so that the parameter files without their sections stay valid.
+ */
+template<typename Container, typename Database>
+auto find_container(Database& db, const char* name) -> std::optional<spark::container_wrapper<Container>>
+{
+    try {
+        return db.template get_container<Container>(name);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+/// Row of the tabular parameter container with the key, nullopt if the container has no such row.
+template<typename Wrapper, typename... Keys>
+auto find_row(Wrapper& par, Keys... keys) -> std::optional<std::remove_cvref_t<decltype(par->get({keys...}))>>
+{
+    try {
+        return par->get({keys...});
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+}  // namespace sabat
@@ -0,0 +1,48 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_checkpoint.hpp"
+#include "sabat/sabat_columnar.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_dst_format.hpp"
+#include "sabat/sabat_event_index.hpp"
+#include "sabat/sabat_hot_channels.hpp"
+#include "sabat/sabat_rate_monitor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace sabat
+{
+
+/**
+ * Processing features of a Sabat system and their settings, given to the system at construction.
+ *
+ * The detector registers the task of an optional feature only when the feature is engaged, and passes the task a
+ * reference to its settings. The application reaches them through sabatsys::setup() to update them between the jobs
+ * (outputs, per-job state), but must not engage or reset the optional features afterwards.
+ */
+struct processing_setup
+{
+    category_demand demand;   ///< categories needed by the writer and consumers
+    size_t task_threads {1};  ///< threads running the tasks of an event, 1 for sequential
+
+    std::optional<uint64_t> sim_seed;                           ///< simulation input, digitized with the seed
+    std::optional<std::vector<event_index_record>> event_index;  ///< records of the current output, one per event
+    std::optional<dst::dst_writer> dst_output;                   ///< compact DST, opened by the application per job
+    std::optional<columnar_options> columnar_output;             ///< Arrow/Parquet export, empty path to close
+    std::optional<rate_monitor> monitor;                         ///< rate monitor of the current output
+    std::optional<hot_channel_detector> hot_channels;            ///< hot channel detector of the current output
+    std::optional<checkpoint_settings> checkpoint;               ///< checkpointing of the current job
+};
+
+}  // namespace sabat
@@ -0,0 +1,310 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace sabat
+{
+
+/**
+ * Time series of the trigger rate, trigger gaps, per-channel hit rate and ToT overflows over the run, in a fixed
+ * number of time bins. The bins start at the first trigger; when a trigger falls past the last bin, pairs of bins are
+ * merged and the bin width doubles, so the memory stays constant for any run length.
+ *
+ * A gap is a trigger interval longer than gap_factor times the mean interval so far. It is counted in the bin where it
+ * ends, its length is split as the dead time over the bins it spans, so the dead fraction of a bin stays within 1.
+ * Timestamps are in the trigger timestamp ticks.
+ *
+ * The channels are keyed by the hardware board of the event (0-255) and the Citiroc channel. The channel counters of
+ * a board are added at its first hit, so only the boards in the data take memory.
+ */
+class rate_monitor
+{
+public:
+    static constexpr size_t n_bins {256};
+    static constexpr size_t n_boards {256};
+    static constexpr size_t n_channels {64};  ///< per board
+
+    struct bin
+    {
+        uint32_t triggers {0};
+        uint32_t gaps {0};
+        uint64_t gap_time {0};  ///< summed length of the gaps [ticks]
+        uint32_t hits {0};
+        uint32_t tot_overflows {0};
+        std::vector<uint32_t> channel_hits;  ///< slot of the board * n_channels + channel
+
+        auto merge(const bin& other) -> void
+        {
+            triggers += other.triggers;
+            gaps += other.gaps;
+            gap_time += other.gap_time;
+            hits += other.hits;
+            tot_overflows += other.tot_overflows;
+            if (channel_hits.size() < other.channel_hits.size()) {
+                channel_hits.resize(other.channel_hits.size());
+            }
+            for (size_t i = 0; i < other.channel_hits.size(); ++i) {
+                channel_hits[i] += other.channel_hits[i];
+            }
+        }
+    };
+
+    /**
+     * \param initial_width width of the bins before any rebinning [ticks]
+     * \param seconds_per_tick length of the timestamp tick, for the rates in the output
+     * \param gap_factor interval to mean interval ratio above which the interval is a gap
+     */
+    explicit rate_monitor(uint64_t initial_width = 1'000'000, double seconds_per_tick = 1e-6, double gap_factor = 10.)
+        : initial_width(std::max<uint64_t>(initial_width, 1))
+        , seconds_per_tick(seconds_per_tick)
+        , gap_factor(gap_factor)
+        , bins(n_bins)
+    {
+        reset();
+    }
+
+    auto reset() -> void
+    {
+        std::ranges::fill(bins, bin {});
+        width = initial_width;
+        t0.reset();
+        last_ts = 0;
+        n_triggers = 0;
+        current = nullptr;
+        used = 0;
+        slots.fill(no_slot);
+        boards.clear();
+    }
+
+    /// Account a trigger, the following hits go to its bin.
+    auto add_trigger(uint64_t trgts) -> void
+    {
+        if (!t0) {
+            t0 = trgts;
+            last_ts = trgts;
+        }
+
+        const auto offset = trgts > *t0 ? trgts - *t0 : 0;
+        while (offset / width >= n_bins) {
+            rebin();
+        }
+
+        const auto idx = static_cast<size_t>(offset / width);
+        current = &bins[idx];
+        used = std::max(used, idx + 1);
+        current->triggers++;
+
+        if (trgts > last_ts) {
+            const auto interval = trgts - last_ts;
+            if (n_triggers >= min_triggers_for_gaps
+                and static_cast<double>(interval) > gap_factor * static_cast<double>(last_ts - *t0) / (n_triggers - 1))
+            {
+                current->gaps++;
+                add_dead_time(last_ts - *t0, offset);
+            }
+            last_ts = trgts;
+        }
+
+        n_triggers++;
+    }
+
+    /// Account a hit of the current trigger on the hardware board and channel.
+    auto add_hit(size_t board, size_t channel, bool tot_overflow) -> void
+    {
+        if (current == nullptr) {
+            return;
+        }
+
+        current->hits++;
+        if (tot_overflow) {
+            current->tot_overflows++;
+        }
+        if (board >= n_boards or channel >= n_channels) {
+            return;
+        }
+
+        if (slots[board] == no_slot) {
+            slots[board] = boards.size();
+            boards.push_back(board);
+        }
+
+        const auto idx = slots[board] * n_channels + channel;
+        if (current->channel_hits.size() <= idx) {
+            current->channel_hits.resize(boards.size() * n_channels);
+        }
+        current->channel_hits[idx]++;
+    }
+
+    auto bin_width() const -> uint64_t { return width; }
+    auto first_timestamp() const -> std::optional<uint64_t> { return t0; }
+    auto used_bins() const -> size_t { return used; }
+    auto get_bin(size_t idx) const -> const bin& { return bins[idx]; }
+
+    /**
+     * Write the used bins as CSV: bin start and end [ticks], trigger rate [Hz], gaps, dead time fraction, hit rate
+     * [Hz], ToT overflow fraction, and the hit rate of each channel of the boards with hits [Hz], in columns
+     * b<board>_ch<channel> ordered by board.
+     */
+    auto write_csv(std::ostream& out) const -> void
+    {
+        auto sorted = boards;
+        std::ranges::sort(sorted);
+
+        out << "t_begin,t_end,trigger_rate,gaps,dead_fraction,hit_rate,tot_overflow_fraction";
+        for (auto board : sorted) {
+            for (size_t ch = 0; ch < n_channels; ++ch) {
+                out << ",b" << board << "_ch" << ch;
+            }
+        }
+        out << '\n';
+
+        const auto seconds = static_cast<double>(width) * seconds_per_tick;
+
+        for (size_t i = 0; i < used; ++i) {
+            const auto& b = bins[i];
+            const auto begin = *t0 + i * width;
+
+            const auto dead_fraction = static_cast<double>(b.gap_time) / static_cast<double>(width);
+            const auto overflow_fraction = b.hits > 0 ? static_cast<double>(b.tot_overflows) / b.hits : 0.;
+
+            out << begin << ',' << begin + width << ',' << b.triggers / seconds << ',' << b.gaps << ',' << dead_fraction
+                << ',' << b.hits / seconds << ',' << overflow_fraction;
+            for (auto board : sorted) {
+                for (size_t ch = 0; ch < n_channels; ++ch) {
+                    const auto idx = slots[board] * n_channels + ch;
+                    out << ',' << (idx < b.channel_hits.size() ? b.channel_hits[idx] : 0) / seconds;
+                }
+            }
+            out << '\n';
+        }
+    }
+
+    /// Write the whole state as text, to continue the monitor with read_state() after a resume.
+    auto write_state(std::ostream& out) const -> void
+    {
+        const auto current_bin = current == nullptr ? used : static_cast<size_t>(current - bins.data());
+
+        out << width << ' ' << t0.has_value() << ' ' << t0.value_or(0) << ' ' << last_ts << ' ' << n_triggers << ' '
+            << used << ' ' << current_bin << '\n';
+
+        out << boards.size();
+        for (auto board : boards) {
+            out << ' ' << board;
+        }
+        out << '\n';
+
+        for (size_t i = 0; i < used; ++i) {
+            const auto& b = bins[i];
+            out << b.triggers << ' ' << b.gaps << ' ' << b.gap_time << ' ' << b.hits << ' ' << b.tot_overflows << ' '
+                << b.channel_hits.size();
+            for (auto hits : b.channel_hits) {
+                out << ' ' << hits;
+            }
+            out << '\n';
+        }
+    }
+
+    /// Restore the state written by write_state(), false and a reset monitor if it is not valid.
+    auto read_state(std::istream& in) -> bool
+    {
+        reset();
+
+        bool has_t0 {false};
+        uint64_t first_ts {0};
+        size_t current_bin {0};
+        size_t n_seen {0};
+
+        in >> width >> has_t0 >> first_ts >> last_ts >> n_triggers >> used >> current_bin >> n_seen;
+        bool valid = in and width > 0 and used <= n_bins and current_bin <= used and n_seen <= n_boards;
+
+        for (size_t s = 0; valid and s < n_seen; ++s) {
+            size_t board {0};
+            valid = (in >> board) and board < n_boards and slots[board] == no_slot;
+            if (valid) {
+                slots[board] = boards.size();
+                boards.push_back(board);
+            }
+        }
+
+        for (size_t i = 0; valid and i < used; ++i) {
+            auto& b = bins[i];
+            size_t n_counters {0};
+            in >> b.triggers >> b.gaps >> b.gap_time >> b.hits >> b.tot_overflows >> n_counters;
+            valid = in and n_counters <= n_seen * n_channels;
+            b.channel_hits.resize(valid ? n_counters : 0);
+            for (auto& hits : b.channel_hits) {
+                in >> hits;
+            }
+            valid = valid and in;
+        }
+
+        if (!valid) {
+            reset();
+            return false;
+        }
+
+        if (has_t0) {
+            t0 = first_ts;
+        }
+        current = current_bin < used ? &bins[current_bin] : nullptr;
+
+        return true;
+    }
+
+private:
+    static constexpr uint64_t min_triggers_for_gaps {100};
+    static constexpr size_t no_slot {n_boards};
+
+    /// Add the part of [begin, end) overlapping each bin to its dead time, offsets from t0.
+    auto add_dead_time(uint64_t begin, uint64_t end) -> void
+    {
+        for (auto idx = static_cast<size_t>(begin / width); begin < end; ++idx) {
+            const auto bin_end = std::min((idx + 1) * width, end);
+            bins[idx].gap_time += bin_end - begin;
+            begin = bin_end;
+        }
+    }
+
+    auto rebin() -> void
+    {
+        for (size_t i = 0; i < n_bins / 2; ++i) {
+            bins[i] = bins[2 * i];
+            bins[i].merge(bins[2 * i + 1]);
+        }
+        std::fill(bins.begin() + n_bins / 2, bins.end(), bin {});
+
+        width *= 2;
+        used = (used + 1) / 2;
+    }
+
+    uint64_t initial_width;
+    double seconds_per_tick;
+    double gap_factor;
+
+    std::vector<bin> bins;
+    uint64_t width {1};
+    std::optional<uint64_t> t0;
+    uint64_t last_ts {0};
+    uint64_t n_triggers {0};
+    bin* current {nullptr};
+    size_t used {0};
+    std::array<size_t, n_boards> slots {};  ///< slot of the board in the channel counters, no_slot if not seen
+    std::vector<size_t> boards;             ///< board of each slot
+};
+
+}  // namespace sabat
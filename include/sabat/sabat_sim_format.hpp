@@ -0,0 +1,243 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_dst_format.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+/**
+ * SABAT simulation input format, the energy deposits and tracks of the Monte Carlo events.
+ *
+ * File: magic, format version, run number, followed by the event frames. Event frame: varint payload size, payload.
+ * Payload: varint event number, varint number of tracks, tracks, varint number of deposits, deposits.
+ * Track: varint track id, zigzag parent id, zigzag PDG code, vertex x, y, z [mm], momentum px, py, pz [MeV], energy
+ * [MeV] as floats. Deposit: varint board, varint channel, varint track id, energy [MeV] and time [ns] as floats.
+ * Varints and zigzag encoding as in the DST format.
+ */
+namespace sabat::sim
+{
+
+inline constexpr std::array<char, 8> magic {'S', 'A', 'B', 'A', 'T', 'S', 'I', 'M'};
+inline constexpr uint16_t format_version {1};
+
+struct track
+{
+    int track_id {-1};
+    int parent_id {-1};
+    int pdg {0};
+    float x {0};
+    float y {0};
+    float z {0};
+    float px {0};
+    float py {0};
+    float pz {0};
+    float energy {0};
+
+    auto operator==(const track&) const -> bool = default;
+};
+
+struct deposit
+{
+    int board {-1};
+    int channel {-1};
+    int track_id {-1};
+    float energy {0};
+    float time {0};
+
+    auto operator==(const deposit&) const -> bool = default;
+};
+
+/// Encode event payload, appended to out.
+inline auto encode_event(uint64_t event,
+                         std::span<const track> tracks,
+                         std::span<const deposit> deposits,
+                         std::vector<std::byte>& out) -> void
+{
+    using dst::append_float;
+    using dst::append_varint;
+    using dst::zigzag;
+
+    append_varint(out, event);
+
+    append_varint(out, tracks.size());
+    for (const auto& trk : tracks) {
+        append_varint(out, static_cast<uint64_t>(trk.track_id));
+        append_varint(out, zigzag(trk.parent_id));
+        append_varint(out, zigzag(trk.pdg));
+        for (auto v : {trk.x, trk.y, trk.z, trk.px, trk.py, trk.pz, trk.energy}) {
+            append_float(out, v);
+        }
+    }
+
+    append_varint(out, deposits.size());
+    for (const auto& dep : deposits) {
+        append_varint(out, static_cast<uint64_t>(dep.board));
+        append_varint(out, static_cast<uint64_t>(dep.channel));
+        append_varint(out, static_cast<uint64_t>(dep.track_id));
+        append_float(out, dep.energy);
+        append_float(out, dep.time);
+    }
+}
+
+/**
+ * Decode event payload. The callbacks are called for each track and deposit.
+ *
+ * \return false if the payload is malformed
+ */
+template<typename TrackCallback, typename DepositCallback>
+auto decode_event(std::span<const std::byte> payload,
+                  uint64_t& event,
+                  TrackCallback&& track_callback,
+                  DepositCallback&& deposit_callback) -> bool
+{
+    using dst::read_float;
+    using dst::read_varint;
+    using dst::unzigzag;
+
+    const auto* p = payload.data();
+    const auto* end = p + payload.size();
+
+    uint64_t v {0};
+
+    if (!read_varint(p, end, event) or !read_varint(p, end, v)) {
+        return false;
+    }
+
+    for (auto n_tracks = v; n_tracks > 0; --n_tracks) {
+        track trk;
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        trk.track_id = static_cast<int>(v);
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        trk.parent_id = static_cast<int>(unzigzag(v));
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        trk.pdg = static_cast<int>(unzigzag(v));
+        for (auto* f : {&trk.x, &trk.y, &trk.z, &trk.px, &trk.py, &trk.pz, &trk.energy}) {
+            if (!read_float(p, end, *f)) {
+                return false;
+            }
+        }
+        track_callback(trk);
+    }
+
+    if (!read_varint(p, end, v)) {
+        return false;
+    }
+
+    for (auto n_deposits = v; n_deposits > 0; --n_deposits) {
+        deposit dep;
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        dep.board = static_cast<int>(v);
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        dep.channel = static_cast<int>(v);
+        if (!read_varint(p, end, v)) {
+            return false;
+        }
+        dep.track_id = static_cast<int>(v);
+        if (!read_float(p, end, dep.energy) or !read_float(p, end, dep.time)) {
+            return false;
+        }
+        deposit_callback(dep);
+    }
+
+    return p == end;
+}
+
+inline auto write_file_header(std::ostream& out, uint16_t run) -> void
+{
+    out.write(magic.data(), magic.size());
+    dst::write_le(out, format_version);
+    dst::write_le(out, run);
+}
+
+/// Read the file header, returns the run number.
+inline auto read_file_header(std::istream& in) -> std::optional<uint16_t>
+{
+    std::array<char, magic.size()> file_magic {};
+    in.read(file_magic.data(), file_magic.size());
+
+    if (!in or file_magic != magic or dst::read_le<uint16_t>(in) != format_version) {
+        return std::nullopt;
+    }
+
+    auto run = dst::read_le<uint16_t>(in);
+    if (!in) {
+        return std::nullopt;
+    }
+
+    return run;
+}
+
+/**
+ * Streaming writer of the simulation input, for the simulation programs and tests.
+ */
+class sim_writer
+{
+public:
+    auto open(const std::filesystem::path& filepath, uint16_t run) -> bool
+    {
+        out = std::ofstream(filepath, std::ios_base::binary);
+        if (!out) {
+            return false;
+        }
+
+        write_file_header(out, run);
+        return static_cast<bool>(out);
+    }
+
+    auto close() -> void
+    {
+        if (out.is_open()) {
+            out.close();
+        }
+    }
+
+    auto write_event(uint64_t event, std::span<const track> tracks, std::span<const deposit> deposits) -> bool
+    {
+        payload.clear();
+        encode_event(event, tracks, deposits, payload);
+
+        frame.clear();
+        dst::append_varint(frame, payload.size());
+
+        out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+        out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+
+        return static_cast<bool>(out);
+    }
+
+private:
+    std::ofstream out;
+    std::vector<std::byte> frame;
+    std::vector<std::byte> payload;
+};
+
+}  // namespace sabat::sim
@@ -0,0 +1,251 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include "sabat/sabat_export.hpp"
+
+#include "sabat/citiroc_types.hpp"
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_sim_format.hpp"
+
+#include <spark/core/data_source.hpp>
+#include <spark/core/unpacker.hpp>
+#include <spark/spark.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace sabat::sim
+{
+
+/**
+ * Extends data_source to read the simulation input files.
+ *
+ * The events can be partitioned between several sources reading the same file: with set_range(begin, end) only the
+ * event frames starting in the byte range are read, the ranges are found with partition_input().
+ */
+class SABAT_EXPORT sim_source : public spark::data_source
+{
+public:
+    sim_source() = default;
+
+    auto read_current_event() -> bool override;
+
+    /**
+     * Set input for the source. If another file is already open, it is closed first.
+     *
+     * \param filename input file name
+     */
+    auto set_input(const std::filesystem::path& filepath) -> void
+    {
+        close();
+        file = filepath;
+    }
+
+    auto set_range(uint64_t begin, uint64_t end) -> void
+    {
+        range_begin = begin;
+        range_end = end;
+    }
+
+    auto open() -> bool override;
+
+    auto close() -> bool override;
+
+    /// Header for the application, the run number of the simulation and the combined acquisition mode.
+    auto header() const -> const spark::citiroc::types::file_header* { return &fheader; }
+
+private:
+    std::filesystem::path file;  ///< file name
+
+    std::ifstream source;                        ///< input file stream
+    spark::citiroc::types::file_header fheader;  ///< header with the simulation run number
+    bool is_open {false};
+
+    uint64_t range_begin {0};                                   ///< offset of the first frame to read
+    uint64_t range_end {std::numeric_limits<uint64_t>::max()};  ///< frames starting at or after are not read
+    uint64_t remaining {0};                                     ///< bytes of the file not read yet
+};
+
+/**
+ * Split the event frames of the simulation file into n_parts consecutive ranges of about the same size. Only the frame
+ * lengths are read, the payloads are skipped.
+ *
+ * \return n_parts + 1 byte offsets, part i reads the frames starting in [offsets[i], offsets[i + 1]), nullopt if the
+ * file is not a simulation file
+ */
+SABAT_EXPORT auto partition_input(const std::filesystem::path& filepath, uint32_t n_parts)
+    -> std::optional<std::vector<uint64_t>>;
+
+/**
+ * Unpacks the simulation event frames into GeantTrack and GeantSiPMRaw, and EventHeader with the simulated event
+ * number as the trigger id and the number of deposits of the event. Tracks and deposits beyond the size of their
+ * categories are dropped with a warning.
+ *
+ * \tparam Category spark::category, or a type with the same object interface
+ */
+template<typename Category>
+class frame_unpacker
+{
+public:
+    frame_unpacker(Category& cat_event_header, Category& cat_geant_track, Category& cat_geant_sipm)
+        : cat_event_header(cat_event_header)
+        , cat_geant_track(cat_geant_track)
+        , cat_geant_sipm(cat_geant_sipm)
+    {
+    }
+
+    /// Read and unpack a frame of the given size, false if the frame is cut short or malformed.
+    auto read_frame(std::istream& source, size_t length) -> bool
+    {
+        payload.resize(length);
+        source.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(length));
+
+        if (!source) {
+            return false;
+        }
+
+        uint64_t event {0};
+        size_t n_tracks {0};
+        size_t n_deposits {0};
+
+        auto ok = decode_event(
+            payload,
+            event,
+            [&](const track& trk)
+            {
+                if (n_tracks++ >= category_size::geant_tracks) {
+                    return;
+                }
+
+                auto obj = cat_geant_track.template make_object_unsafe<GeantTrack>({n_tracks - 1});
+                obj->track_id = trk.track_id;
+                obj->parent_id = trk.parent_id;
+                obj->pdg = trk.pdg;
+                obj->x = trk.x;
+                obj->y = trk.y;
+                obj->z = trk.z;
+                obj->px = trk.px;
+                obj->py = trk.py;
+                obj->pz = trk.pz;
+                obj->energy = trk.energy;
+            },
+            [&](const deposit& dep)
+            {
+                if (n_deposits++ >= category_size::geant_deposits) {
+                    return;
+                }
+
+                auto obj = cat_geant_sipm.template make_object_unsafe<GeantSiPMRaw>({n_deposits - 1});
+                obj->event = static_cast<int>(event);
+                obj->board = dep.board;
+                obj->channel = dep.channel;
+                obj->track_id = dep.track_id;
+                obj->energy = dep.energy;
+                obj->time = dep.time;
+            });
+
+        if (!ok) {
+            spdlog::error("[{}] Malformed simulation event", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        if (n_tracks > category_size::geant_tracks) {
+            spdlog::warn("[{}] Dropped {} of {} tracks of event {} beyond the GeantTrack category",
+                         __PRETTY_FUNCTION__,
+                         n_tracks - category_size::geant_tracks,
+                         n_tracks,
+                         event);
+        }
+
+        if (n_deposits > category_size::geant_deposits) {
+            spdlog::warn("[{}] Dropped {} of {} deposits of event {} beyond the GeantSiPMRaw category",
+                         __PRETTY_FUNCTION__,
+                         n_deposits - category_size::geant_deposits,
+                         n_deposits,
+                         event);
+        }
+
+        auto hdr_obj = cat_event_header.template make_object_unsafe<EventHeader>({0});
+        hdr_obj->trgid = event;
+        hdr_obj->nhits = static_cast<int>(n_deposits);
+
+        return true;
+    }
+
+private:
+    Category& cat_event_header;
+    Category& cat_geant_track;
+    Category& cat_geant_sipm;
+    std::vector<std::byte> payload;
+};
+
+/**
+ * Fills GeantTrack, GeantSiPMRaw and EventHeader from the simulation event frames with frame_unpacker.
+ */
+class SABAT_EXPORT sim_unpacker : public spark::unpacker
+{
+public:
+    using unpacker::unpacker;
+
+    auto init() -> bool override
+    {
+        unpacker::init();
+
+        cat_geant_track = model()->template build_category<GeantTrack>(SabatCategories::GeantTrack);
+
+        if (cat_geant_track == nullptr) {
+            spdlog::critical("[{}] No GeantTrack category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_geant_sipm = model()->template build_category<GeantSiPMRaw>(SabatCategories::GeantSiPMRaw);
+
+        if (cat_geant_sipm == nullptr) {
+            spdlog::critical("[{}] No GeantSiPMRaw category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_event_header = model()->template build_category<EventHeader>(SabatCategories::EventHeader);
+
+        if (cat_event_header == nullptr) {
+            spdlog::critical("[{}] No EventHeader category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        reader.emplace(*cat_event_header, *cat_geant_track, *cat_geant_sipm);
+
+        return true;
+    }
+
+    auto execute(uint64_t /*event*/,
+                 uint64_t /*seq_number*/,
+                 uint16_t /*subevent*/,
+                 std::istream& source,
+                 size_t length) -> bool override
+    {
+        return reader->read_frame(source, length);
+    }
+
+private:
+    spark::category* cat_geant_track {nullptr};
+    spark::category* cat_geant_sipm {nullptr};
+    spark::category* cat_event_header {nullptr};
+    std::optional<frame_unpacker<spark::category>> reader;
+};
+
+}  // namespace sabat::sim
@@ -14,11 +14,23 @@
 #include "sabat/citiroc_types.hpp"
 #include "sabat/sabat_categories.hpp"
 #include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_demand.hpp"
+
+#include <array>
+#include <utility>
 
 class sabat_calibration : public spark::task
 {
 public:
-    using task::task;
+    template<typename... Args>
+    explicit sabat_calibration(sabat::category_demand& demand, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::SiPMRaw};
+    static constexpr std::array outputs {SabatCategories::SiPMCal};
 
     auto init() -> bool override
     {
@@ -39,11 +51,17 @@ public:
         pm_cal = db()->get_container<SiPMCalPar>("SiPMCalPar");
         pm_cal->print();
 
+        demand.add_producer(inputs, outputs);
+
         return true;
     }
 
     auto execute() -> bool override
     {
+        if (!demand.any_required(outputs)) {
+            return true;
+        }
+
         auto n_objs = cat_sipm_raw->get_entries();
 
         for (int i = 0; i < n_objs; ++i) {
@@ -66,6 +84,8 @@ public:
     }
 
 private:
+    sabat::category_demand& demand;
+
     spark::category* cat_sipm_raw {nullptr};
     spark::category* cat_sipm_cal {nullptr};
 
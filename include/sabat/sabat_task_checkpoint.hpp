@@ -0,0 +1,125 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+
+#include "sabat/sabat_checkpoint.hpp"
+#include "sabat/sabat_event_index.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+/**
+ * Writes a checkpoint every interval events of the job, as set by the application in the checkpoint settings. The task
+ * runs before the event is filled into the output, so the saved tree holds exactly the events before the current one,
+ * and the checkpoint points to the input offset of the current event. When the event index is collected, the records
+ * of the saved entries are appended to the checkpoint index before each checkpoint, so a resumed job can write the
+ * index of the whole output. The application saves the state of the other outputs with each checkpoint, so the rate
+ * monitor and the hot channel detection run after this task. It saves the output file, so it runs alone in the task
+ * graph.
+ */
+class sabat_checkpointing : public spark::task
+{
+public:
+    /// \param index records of the output, nullptr if the event index is not collected
+    template<typename... Args>
+    explicit sabat_checkpointing(const sabat::checkpoint_settings& settings,
+                                 const std::vector<sabat::event_index_record>* index,
+                                 Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , settings(settings)
+        , index(index)
+    {
+    }
+
+    static constexpr bool barrier {true};
+
+    auto execute() -> bool override
+    {
+        if (settings.file.empty() or settings.interval <= 0 or !settings.input_offset) {
+            return true;
+        }
+
+        if (settings.output != current_output) {
+            current_output = settings.output;
+            processed = 0;
+            index_saved = settings.start.entries;
+        }
+
+        if (processed > 0 and processed % settings.interval == 0) {
+            save();
+        }
+
+        processed++;
+
+        return true;
+    }
+
+private:
+    auto save() -> void
+    {
+        auto entries = sabat::save_output(settings.output, "T");
+        if (!entries) {
+            spdlog::warn(
+                "[{}] Cannot save output {}, checkpoint skipped", __PRETTY_FUNCTION__, settings.output.string());
+            return;
+        }
+
+        sabat::checkpoint ckpt {
+            .input = settings.start.input,
+            .offset = settings.input_offset(),
+            .event = settings.start.event + processed,
+            .entries = settings.start.entries + *entries,
+            .run = settings.start.run,
+        };
+
+        if (index != nullptr and !settings.index_file.empty()) {
+            save_index(ckpt.entries);
+        }
+
+        if (settings.save_state and !settings.save_state(ckpt.entries)) {
+            spdlog::warn("[{}] Cannot save the state of the outputs, checkpoint skipped", __PRETTY_FUNCTION__);
+            return;
+        }
+
+        if (sabat::write_checkpoint(settings.file, ckpt)) {
+            spdlog::debug("[{}] Checkpoint at event {}, {} entries", __PRETTY_FUNCTION__, ckpt.event, ckpt.entries);
+        }
+    }
+
+    /// Append the index records of the entries saved since the last checkpoint. The records cover the whole output,
+    /// including the entries before the resume. After a failure the index is not saved any more.
+    auto save_index(int64_t entries) -> void
+    {
+        const auto& records = *index;
+
+        if (index_saved < 0 or entries < index_saved or std::cmp_greater(entries, records.size())) {
+            index_saved = -1;
+            return;
+        }
+
+        const auto begin = records.begin() + index_saved;
+        if (!sabat::append_checkpoint_index(settings.index_file, {begin, records.begin() + entries})) {
+            index_saved = -1;
+            return;
+        }
+
+        index_saved = entries;
+    }
+
+    const sabat::checkpoint_settings& settings;
+    const std::vector<sabat::event_index_record>* index;
+
+    std::filesystem::path current_output;
+    int64_t processed {0};
+    int64_t index_saved {0};  ///< entries with index records in the checkpoint index, negative after a failure
+};
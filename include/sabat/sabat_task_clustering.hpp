@@ -10,10 +10,26 @@
 
 #include <spark/core/task.hpp>
 
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_geometry.hpp"
+
+#include <array>
+#include <utility>
+
 class sabat_clustering : public spark::task
 {
 public:
-    using task::task;
+    template<typename... Args>
+    explicit sabat_clustering(sabat::category_demand& demand, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::SiPMCal};
+    static constexpr std::array outputs {SabatCategories::PhotonHit};
 
     auto init() -> bool override
     {
@@ -31,14 +47,24 @@ public:
             return false;
         }
 
+        geometry = sabat::load_geometry(*db());
+
+        demand.add_producer(inputs, outputs);
+
         return true;
     }
 
     auto execute() -> bool override
     {
+        if (!demand.any_required(outputs)) {
+            return true;
+        }
+
         auto n_objs = cat_sipm_cal->get_entries();
 
         float energy_sum = 0.0;
+        float x_sum = 0.0;
+        float y_sum = 0.0;
         int count {0};
 
         for (int i = 0; i < n_objs; ++i) {
@@ -47,13 +73,21 @@ public:
             auto cal_obj = cat_sipm_cal->get_object<SiPMCal>(i);
 
             if (cal_obj->board == 0) {
+                const auto& pos = geometry.position(cal_obj->board, cal_obj->channel);
+
                 energy_sum += cal_obj->energy;
+                x_sum += pos.x * cal_obj->energy;
+                y_sum += pos.y * cal_obj->energy;
                 count++;
             }
         }
 
         auto new_hit_obj = cat_photon_hit->make_object_unsafe<PhotonHit>({0, 0});
         new_hit_obj->board = 0;
+        if (energy_sum > 0) {
+            new_hit_obj->x = x_sum / energy_sum;
+            new_hit_obj->y = y_sum / energy_sum;
+        }
         new_hit_obj->energy = energy_sum;
         new_hit_obj->mult = count;
 
@@ -61,6 +95,10 @@ public:
     }
 
 private:
+    sabat::category_demand& demand;
+
     spark::category* cat_sipm_cal {nullptr};
     spark::category* cat_photon_hit {nullptr};
+
+    sabat::detector_geometry geometry;
 };
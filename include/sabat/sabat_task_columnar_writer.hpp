@@ -0,0 +1,111 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_columnar.hpp"
+#include "sabat/sabat_demand.hpp"
+
+#include <array>
+#include <filesystem>
+#include <utility>
+
+/**
+ * Exports SiPMRaw, SiPMCal and PhotonHit of each event into the Arrow/Parquet file of the columnar options, beside the
+ * ROOT tree. The file is (re)opened whenever the application changes the output path, nothing is written when it is
+ * empty.
+ */
+class sabat_columnar_writer : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_columnar_writer(sabat::category_demand& demand, sabat::columnar_options& options, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , options(options)
+    {
+    }
+
+    static constexpr std::array inputs {
+        SabatCategories::EventHeader, SabatCategories::SiPMRaw, SabatCategories::SiPMCal, SabatCategories::PhotonHit};
+
+    auto init() -> bool override
+    {
+        for (auto cat : inputs) {
+            demand.require(cat);
+        }
+
+        cat_event_header = model()->get_category(SabatCategories::EventHeader);
+        cat_sipm_raw = model()->get_category(SabatCategories::SiPMRaw);
+        cat_sipm_cal = model()->get_category(SabatCategories::SiPMCal);
+        cat_photon_hit = model()->get_category(SabatCategories::PhotonHit);
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (options.path.empty()) {
+            if (writer.is_open()) {
+                writer.close();
+                current_output.clear();
+            }
+            return true;
+        }
+
+        if (options.path != current_output) {
+            if (!writer.open(options)) {
+                spdlog::critical("[{}] Cannot open columnar output {}", __PRETTY_FUNCTION__, options.path.string());
+                return false;
+            }
+            current_output = options.path;
+        }
+
+        if (cat_event_header != nullptr and cat_event_header->get_entries() > 0) {
+            auto hdr_obj = cat_event_header->get_object<EventHeader>(0);
+            writer.begin_event(hdr_obj->trgts, hdr_obj->trgid);
+        } else {
+            writer.begin_event(0, 0);
+        }
+
+        append_all<SiPMRaw>(cat_sipm_raw);
+        append_all<SiPMCal>(cat_sipm_cal);
+        append_all<PhotonHit>(cat_photon_hit);
+
+        return writer.end_event();
+    }
+
+private:
+    template<typename T>
+    auto append_all(spark::category* cat) -> void
+    {
+        if (cat == nullptr) {
+            return;
+        }
+
+        auto n_objs = cat->get_entries();
+        for (int i = 0; i < n_objs; ++i) {
+            writer.append(*cat->get_object<T>(i));
+        }
+    }
+
+    sabat::category_demand& demand;
+    sabat::columnar_options& options;
+
+    spark::category* cat_event_header {nullptr};
+    spark::category* cat_sipm_raw {nullptr};
+    spark::category* cat_sipm_cal {nullptr};
+    spark::category* cat_photon_hit {nullptr};
+
+    sabat::columnar_writer writer;
+    std::filesystem::path current_output;
+};
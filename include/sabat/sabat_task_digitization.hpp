@@ -0,0 +1,266 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_demand.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace sabat::sim
+{
+
+constexpr auto splitmix64(uint64_t x) -> uint64_t
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Small random generator (xoshiro256**) for the standard distributions. It is seeded from the run seed, the
+ * simulated event and the channel, so the digitization of a channel does not depend on the processing order.
+ */
+class channel_rng
+{
+public:
+    using result_type = uint64_t;
+
+    channel_rng(uint64_t seed, uint64_t event, uint64_t board, uint64_t channel)
+    {
+        auto x = splitmix64(seed) ^ splitmix64(event ^ 0x5ab47ULL) ^ splitmix64((board << 8 | channel) + 0x1000);
+        for (auto& s : state) {
+            x = splitmix64(x);
+            s = x;
+        }
+    }
+
+    static constexpr auto min() -> result_type { return 0; }
+    static constexpr auto max() -> result_type { return std::numeric_limits<result_type>::max(); }
+
+    auto operator()() -> result_type
+    {
+        const auto result = std::rotl(state[1] * 5, 7) * 9;
+        const auto t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = std::rotl(state[3], 45);
+
+        return result;
+    }
+
+private:
+    std::array<uint64_t, 4> state {};
+};
+
+/**
+ * Digitization of the deposits of an event, as done by sabat_digitization. The parameters of a board are read with
+ * get({board}) as from SiPMDigiPar.
+ */
+class event_digitizer
+{
+public:
+    static constexpr int n_boards {static_cast<int>(category_size::modules)};
+    static constexpr int n_channels {static_cast<int>(category_size::sipms)};
+    static constexpr float time_lsb {0.5};  ///< Citiroc ToA/ToT LSB [ns]
+    static constexpr int adc_max {8191};
+
+    explicit event_digitizer(uint64_t seed)
+        : seed(seed)
+    {
+    }
+
+    /**
+     * Digitize the GeantSiPMRaw deposits of the event into SiPMRaw.
+     *
+     * \tparam Category spark::category, or a type with the same object interface
+     * \tparam Params SiPMDigiPar container, or a type with the same get()
+     */
+    template<typename Category, typename Params>
+    auto execute(Category& cat_geant_sipm, Category& cat_sipm_raw, Params& digi_par) -> void
+    {
+        auto n_objs = cat_geant_sipm.get_entries();
+
+        touched.clear();
+
+        for (int i = 0; i < n_objs; ++i) {
+            auto dep = cat_geant_sipm.template get_object<GeantSiPMRaw>(i);
+
+            if (dep->board < 0 or dep->board >= n_boards or dep->channel < 0 or dep->channel >= n_channels) {
+                spdlog::warn("[{}] Deposit in invalid channel {}:{}", __PRETTY_FUNCTION__, dep->board, dep->channel);
+                continue;
+            }
+
+            auto& sum = channels[dep->board * n_channels + dep->channel];
+            if (!sum.hit) {
+                touched.push_back(dep->board * n_channels + dep->channel);
+                sum.hit = true;
+                sum.time = dep->time;
+            }
+
+            sum.event = dep->event;
+            sum.energy += dep->energy;
+            sum.time = std::min(sum.time, dep->time);
+        }
+
+        std::ranges::sort(touched);
+
+        for (auto idx : touched) {
+            digitize(idx / n_channels, idx % n_channels, channels[idx], cat_sipm_raw, digi_par);
+            channels[idx] = {};
+        }
+    }
+
+private:
+    struct channel_sum
+    {
+        bool hit {false};
+        int event {-1};
+        float energy {0};
+        float time {0};
+    };
+
+    static auto quantize(float t) -> float { return std::floor(t / time_lsb) * time_lsb; }
+
+    template<typename Category, typename Params>
+    auto digitize(int board, int channel, const channel_sum& sum, Category& cat_sipm_raw, Params& digi_par) -> void
+    {
+        auto [pe_per_mev, threshold_pe, tot_tau, jitter, lg_gain, hg_gain] =
+            digi_par->get({static_cast<uint8_t>(board)});
+
+        channel_rng rng(
+            seed, static_cast<uint64_t>(sum.event), static_cast<uint64_t>(board), static_cast<uint64_t>(channel));
+
+        const auto mean_pe = static_cast<double>(sum.energy) * pe_per_mev;
+        if (mean_pe <= 0) {
+            return;
+        }
+
+        const auto npe = std::poisson_distribution<int>(mean_pe)(rng);
+        if (npe <= 0 or npe < threshold_pe) {
+            return;
+        }
+
+        auto toa = sum.time;
+        if (jitter > 0) {
+            toa += std::normal_distribution<float>(0, jitter)(rng);
+        }
+
+        const auto tot = tot_tau * std::log(npe / std::max(threshold_pe, 1.f));
+
+        auto obj = cat_sipm_raw.template make_object_unsafe<SiPMRaw>(
+            {static_cast<size_t>(board), static_cast<size_t>(channel)});
+
+        obj->board = board;
+        obj->channel = channel;
+        obj->sipm = channel;
+        obj->toa = quantize(std::max(toa, 0.f));
+        obj->tot = quantize(tot);
+        obj->lgpha = std::min(static_cast<int>(std::lround(npe * lg_gain)), adc_max);
+        obj->hgpha = std::min(static_cast<int>(std::lround(npe * hg_gain)), adc_max);
+    }
+
+    uint64_t seed;
+
+    std::array<channel_sum, n_boards * n_channels> channels {};
+    std::vector<int> touched;
+};
+
+}  // namespace sabat::sim
+
+/**
+ * Digitizes the simulated SiPM energy deposits from GeantSiPMRaw into SiPMRaw, so the simulation goes through the same
+ * calibration and reconstruction as the data.
+ *
+ * Deposits of a channel are summed, the number of photo-electrons is drawn from Poisson distribution, channels below
+ * the discriminator threshold are dropped. ToT follows the shaper discharge, tau * ln(npe / threshold), ToA is the
+ * time of the earliest deposit smeared by the jitter. Both are quantized to the Citiroc 0.5 ns LSB, PHA is
+ * npe * gain limited to the ADC range. Parameters per board in SiPMDigiPar: photo-electrons per MeV, threshold [pe],
+ * ToT tau [ns], jitter [ns], LG gain, HG gain [ADC/pe]. Deposits are stored per readout channel, SiPMRaw sipm is the
+ * channel.
+ *
+ * Random numbers are seeded per run seed, simulated event and channel, so the output is reproducible for any number of
+ * threads or file partitions. The task is set up only for simulation input, with the seed of the processing.
+ */
+class sabat_digitization : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_digitization(sabat::category_demand& demand, uint64_t seed, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , digitizer(seed)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::GeantSiPMRaw};
+    static constexpr std::array outputs {SabatCategories::SiPMRaw};
+
+    auto init() -> bool override
+    {
+        cat_geant_sipm = model()->get_category(SabatCategories::GeantSiPMRaw);
+
+        if (cat_geant_sipm == nullptr) {
+            spdlog::info("[{}] No GeantSiPMRaw category, digitization disabled", __PRETTY_FUNCTION__);
+            return true;
+        }
+
+        cat_sipm_raw = model()->build_category<SiPMRaw>(SabatCategories::SiPMRaw);
+
+        if (cat_sipm_raw == nullptr) {
+            spdlog::critical("[{}] Cannot build SiPMRaw category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        digi_par = db()->get_container<SiPMDigiPar>("SiPMDigiPar");
+
+        demand.add_producer(inputs, outputs);
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (cat_geant_sipm == nullptr or !demand.any_required(outputs)) {
+            return true;
+        }
+
+        digitizer.execute(*cat_geant_sipm, *cat_sipm_raw, digi_par);
+
+        return true;
+    }
+
+private:
+    sabat::category_demand& demand;
+
+    spark::category* cat_geant_sipm {nullptr};
+    spark::category* cat_sipm_raw {nullptr};
+
+    spark::container_wrapper<SiPMDigiPar> digi_par;
+
+    sabat::sim::event_digitizer digitizer;
+};
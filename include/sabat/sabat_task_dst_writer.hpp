@@ -0,0 +1,101 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_dst_format.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+/**
+ * Streams EventHeader and SiPMRaw of each event into the compact DST writer. The application opens and closes the
+ * writer for each job, nothing is written when it is not open.
+ */
+class sabat_dst_writer : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_dst_writer(sabat::category_demand& demand, sabat::dst::dst_writer& output, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , output(output)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::EventHeader, SabatCategories::SiPMRaw};
+
+    auto init() -> bool override
+    {
+        cat_sipm_raw = model()->get_category(SabatCategories::SiPMRaw);
+
+        if (cat_sipm_raw == nullptr) {
+            spdlog::critical("[{}] No SiPMRaw category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_event_header = model()->get_category(SabatCategories::EventHeader);
+
+        demand.require(SabatCategories::SiPMRaw);
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (!output.is_open()) {
+            return true;
+        }
+
+        auto n_objs = cat_sipm_raw->get_entries();
+
+        hits.clear();
+        for (int i = 0; i < n_objs; ++i) {
+            auto raw_obj = cat_sipm_raw->get_object<SiPMRaw>(i);
+            hits.push_back({raw_obj->board,
+                            raw_obj->channel,
+                            raw_obj->sipm,
+                            raw_obj->toa,
+                            raw_obj->tot,
+                            raw_obj->lgpha,
+                            raw_obj->hgpha});
+        }
+
+        spark::citiroc::types::event_header header;
+        if (cat_event_header != nullptr and cat_event_header->get_entries() > 0) {
+            auto hdr_obj = cat_event_header->get_object<EventHeader>(0);
+            header.brd = static_cast<uint8_t>(hdr_obj->board);
+            header.trgts = hdr_obj->trgts;
+            header.trgid = hdr_obj->trgid;
+            header.chmask = hdr_obj->chmask;
+            header.flags = static_cast<uint16_t>(hdr_obj->flags);
+        }
+
+        if (!output.write_event(header, hits)) {
+            spdlog::critical("[{}] Cannot write DST event (hit channel outside 0-255 or write error)",
+                             __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    spark::category* cat_sipm_raw {nullptr};
+    spark::category* cat_event_header {nullptr};
+    sabat::category_demand& demand;
+    sabat::dst::dst_writer& output;
+
+    std::vector<sabat::dst::raw_hit> hits;
+};
@@ -0,0 +1,92 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_event_index.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * Collects the event index record of each event into the records of the current output, the application writes them
+ * next to the output tree at the end of the file. Record: trigger timestamp from EventHeader, multiplicity of SiPMRaw,
+ * sum of PhotonHit energies.
+ *
+ * The index requires only EventHeader, so it does not switch on the reconstruction skipped by the category demand
+ * (e.g. --store SiPMRaw). The energy is summed only when PhotonHit is needed anyway, otherwise it is NaN and the event
+ * fails any energy selection.
+ */
+class sabat_event_indexing : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_event_indexing(sabat::category_demand& demand,
+                                  std::vector<sabat::event_index_record>& records,
+                                  Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , records(records)
+    {
+    }
+
+    static constexpr std::array inputs {
+        SabatCategories::EventHeader, SabatCategories::SiPMRaw, SabatCategories::PhotonHit};
+
+    auto init() -> bool override
+    {
+        demand.require(SabatCategories::EventHeader);
+
+        cat_event_header = model()->get_category(SabatCategories::EventHeader);
+        cat_sipm_raw = model()->get_category(SabatCategories::SiPMRaw);
+        cat_photon_hit = model()->get_category(SabatCategories::PhotonHit);
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        sabat::event_index_record rec;
+
+        if (cat_event_header != nullptr and cat_event_header->get_entries() > 0) {
+            rec.trgts = cat_event_header->get_object<EventHeader>(0)->trgts;
+        }
+
+        if (cat_sipm_raw != nullptr) {
+            rec.multiplicity = static_cast<uint32_t>(cat_sipm_raw->get_entries());
+        }
+
+        if (!demand.is_required(SabatCategories::PhotonHit)) {
+            rec.energy = std::numeric_limits<float>::quiet_NaN();
+        } else if (cat_photon_hit != nullptr) {
+            auto n_objs = cat_photon_hit->get_entries();
+            for (int i = 0; i < n_objs; ++i) {
+                rec.energy += cat_photon_hit->get_object<PhotonHit>(i)->energy;
+            }
+        }
+
+        records.push_back(rec);
+
+        return true;
+    }
+
+private:
+    sabat::category_demand& demand;
+    std::vector<sabat::event_index_record>& records;
+
+    spark::category* cat_event_header {nullptr};
+    spark::category* cat_sipm_raw {nullptr};
+    spark::category* cat_photon_hit {nullptr};
+};
@@ -0,0 +1,337 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace sabat
+{
+
+template<typename T>
+constexpr auto type_name() -> std::string_view
+{
+    std::string_view name = __PRETTY_FUNCTION__;
+    auto begin = name.find("T = ") + 4;
+    auto end = name.find_first_of(";]", begin);
+    return name.substr(begin, end - begin);
+}
+
+/// Categories read by the task, empty if the task does not declare them.
+template<typename T>
+constexpr auto task_inputs() -> std::span<const SabatCategories>
+{
+    if constexpr (requires { T::inputs; }) {
+        return T::inputs;
+    } else {
+        return {};
+    }
+}
+
+/// Categories written by the task, empty if the task does not declare them.
+template<typename T>
+constexpr auto task_outputs() -> std::span<const SabatCategories>
+{
+    if constexpr (requires { T::outputs; }) {
+        return T::outputs;
+    } else {
+        return {};
+    }
+}
+
+/// Whether the task has side effects outside of the categories and must run alone: tasks which declare neither inputs
+/// nor outputs, unless they state otherwise with a static barrier member.
+template<typename T>
+constexpr auto task_is_barrier() -> bool
+{
+    if constexpr (requires { T::barrier; }) {
+        return T::barrier;
+    } else {
+        return task_inputs<T>().empty() and task_outputs<T>().empty();
+    }
+}
+
+}  // namespace sabat
+
+/**
+ * Runs the tasks of one event concurrently, respecting the dependencies between them.
+ *
+ * The nodes are added by the setup function given to the constructor, in the order of execution. The dependencies
+ * follow from the categories declared by the tasks in their inputs and outputs: a task runs after each earlier task
+ * which writes a category it reads or writes, or reads a category it writes. Tasks which do not declare their
+ * categories (see sabat::task_is_barrier()) are barriers: they run after all earlier tasks and before all later ones.
+ * Independent tasks are executed on the work-stealing pool, the thread calling execute() takes part in the work. Tasks
+ * must therefore not share any state except through the categories and their settings. The other task hooks are
+ * forwarded to the nodes sequentially, in the order of execution.
+ *
+ * Start and end of each task are recorded per event. The critical path is traced back from the last finished task
+ * through the latest finished dependency, it is logged at debug level for each event and summarised at the end.
+ */
+class sabat_task_dag : public spark::task
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// Adds the nodes to the graph, each constructed with its own arguments followed by those of the graph task.
+    template<typename... Args>
+    class node_list
+    {
+    public:
+        node_list(sabat_task_dag& graph, Args&... args)
+            : graph(graph)
+            , args(args...)
+        {
+        }
+
+        template<typename T, typename... Own>
+        auto add(Own&&... own) -> void
+        {
+            auto task = std::apply([&](auto&... task_args) { return std::make_unique<T>(own..., task_args...); }, args);
+            graph.add_node(std::move(task),
+                           sabat::type_name<T>(),
+                           sabat::task_inputs<T>(),
+                           sabat::task_outputs<T>(),
+                           sabat::task_is_barrier<T>());
+        }
+
+    private:
+        sabat_task_dag& graph;
+        std::tuple<Args&...> args;
+    };
+
+    /**
+     * \param n_threads threads running the tasks, including the calling one
+     * \param setup called with a node_list to add the nodes
+     * \param args arguments of the task, passed also to each node
+     */
+    template<typename Setup, typename... Args>
+    sabat_task_dag(size_t n_threads, Setup&& setup, Args&&... args)
+        : task(args...)
+        , pool(std::max<size_t>(n_threads, 1) - 1)
+    {
+        node_list<Args...> list(*this, args...);
+        setup(list);
+        connect();
+    }
+
+    sabat_task_dag(const sabat_task_dag&) = delete;
+    auto operator=(const sabat_task_dag&) -> sabat_task_dag& = delete;
+
+    ~sabat_task_dag() override
+    {
+        if (n_events == 0) {
+            return;
+        }
+
+        spdlog::info("[sabat_task_dag] {} events, {} threads, mean latency {:.1f} us, mean work {:.1f} us",
+                     n_events,
+                     pool.size() + 1,
+                     to_us(total_latency) / n_events,
+                     to_us(total_work) / n_events);
+
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            spdlog::info("[sabat_task_dag]   {:<24} mean {:8.1f} us, on critical path in {:5.1f}% of events",
+                         nodes[n].name,
+                         to_us(nodes[n].total_time) / n_events,
+                         100. * nodes[n].on_critical_path / n_events);
+        }
+    }
+
+    auto init() -> bool override { return for_each_node(&spark::task::init, "Initialization"); }
+
+    auto reinit() -> bool override { return for_each_node(&spark::task::reinit, "Reinitialization"); }
+
+    auto finalize() -> bool override { return for_each_node(&spark::task::finalize, "Finalization"); }
+
+    auto execute() -> bool override
+    {
+        if (nodes.empty()) {
+            return true;
+        }
+
+        event_start = clock::now();
+        failed = false;
+
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            waiting[n] = nodes[n].depends.size();
+        }
+        remaining = nodes.size();
+
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            if (nodes[n].depends.empty()) {
+                pool.submit([this, n] { run_node(n); });
+            }
+        }
+
+        for (auto left = remaining.load(); left > 0; left = remaining.load()) {
+            if (!pool.run_one()) {
+                remaining.wait(left);
+            }
+        }
+
+        trace_critical_path();
+
+        return !failed;
+    }
+
+    /// Node indexes on the critical path of the last event, in execution order.
+    auto critical_path() const -> std::span<const size_t> { return last_path; }
+
+    auto node_name(size_t n) const -> std::string_view { return nodes[n].name; }
+
+private:
+    struct node
+    {
+        std::unique_ptr<spark::task> task;
+        std::string_view name;
+        std::span<const SabatCategories> inputs;
+        std::span<const SabatCategories> outputs;
+        bool barrier {false};
+
+        std::vector<size_t> depends {};
+        std::vector<size_t> successors {};
+
+        clock::duration start {};  ///< of the last event
+        clock::duration end {};
+        clock::duration total_time {};
+        size_t on_critical_path {0};
+    };
+
+    static auto to_us(clock::duration d) -> double { return std::chrono::duration<double, std::micro>(d).count(); }
+
+    auto add_node(std::unique_ptr<spark::task> task,
+                  std::string_view name,
+                  std::span<const SabatCategories> inputs,
+                  std::span<const SabatCategories> outputs,
+                  bool barrier) -> void
+    {
+        nodes.push_back(
+            {.task = std::move(task), .name = name, .inputs = inputs, .outputs = outputs, .barrier = barrier});
+    }
+
+    auto connect() -> void
+    {
+        auto overlaps = [](auto a, auto b)
+        { return std::ranges::any_of(a, [&](auto cat) { return std::ranges::find(b, cat) != b.end(); }); };
+
+        for (size_t j = 0; j < nodes.size(); ++j) {
+            for (size_t i = 0; i < j; ++i) {
+                const auto& a = nodes[i];
+                const auto& b = nodes[j];
+                if (a.barrier or b.barrier or overlaps(b.inputs, a.outputs) or overlaps(b.outputs, a.outputs)
+                    or overlaps(b.outputs, a.inputs))
+                {
+                    nodes[j].depends.push_back(i);
+                    nodes[i].successors.push_back(j);
+                }
+            }
+        }
+
+        waiting = std::vector<std::atomic<size_t>>(nodes.size());
+    }
+
+    auto for_each_node(bool (spark::task::*hook)(), std::string_view stage) -> bool
+    {
+        for (auto& n : nodes) {
+            if (!((*n.task).*hook)()) {
+                spdlog::critical("[sabat_task_dag] {} of {} failed", stage, n.name);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    auto run_node(size_t n) -> void
+    {
+        auto& nd = nodes[n];
+
+        auto start = clock::now();
+        if (!failed and !nd.task->execute()) {
+            failed = true;
+        }
+        nd.start = start - event_start;
+        nd.end = clock::now() - event_start;
+
+        for (auto s : nd.successors) {
+            if (--waiting[s] == 0) {
+                pool.submit([this, s] { run_node(s); });
+            }
+        }
+
+        remaining--;
+        remaining.notify_all();
+    }
+
+    auto trace_critical_path() -> void
+    {
+        n_events++;
+
+        auto last = static_cast<size_t>(std::ranges::max_element(nodes, {}, &node::end) - nodes.begin());
+        total_latency += nodes[last].end;
+
+        for (auto& nd : nodes) {
+            nd.total_time += nd.end - nd.start;
+            total_work += nd.end - nd.start;
+        }
+
+        last_path.clear();
+        for (auto n = last;;) {
+            last_path.push_back(n);
+            nodes[n].on_critical_path++;
+
+            if (nodes[n].depends.empty()) {
+                break;
+            }
+            n = *std::ranges::max_element(nodes[n].depends, {}, [&](auto d) { return nodes[d].end; });
+        }
+        std::ranges::reverse(last_path);
+
+        if (spdlog::should_log(spdlog::level::debug)) {
+            std::string path;
+            for (auto n : last_path) {
+                path += fmt::format("{}{} ({:.1f} us)",
+                                    path.empty() ? "" : " -> ",
+                                    nodes[n].name,
+                                    to_us(nodes[n].end - nodes[n].start));
+            }
+            spdlog::debug("[sabat_task_dag] critical path {:.1f} us: {}", to_us(nodes[last].end), path);
+        }
+    }
+
+    std::vector<node> nodes;
+
+    std::vector<std::atomic<size_t>> waiting;
+    std::atomic<size_t> remaining {0};
+    std::atomic<bool> failed {false};
+
+    clock::time_point event_start;
+
+    size_t n_events {0};
+    clock::duration total_latency {};
+    clock::duration total_work {};
+    std::vector<size_t> last_path;
+
+    sabat::work_stealing_pool pool;  ///< last member, stopped before the nodes are destroyed
+};
@@ -0,0 +1,100 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_hot_channels.hpp"
+#include "sabat/sabat_parameters.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+/**
+ * Feeds the hot channel detector with the SiPMRaw hits. The mask in use is taken from SabatChannelMask of the run, in
+ * init() and reinit(); the application writes the suggested mask at the end of each output.
+ *
+ * The hits are keyed by the hardware board of the event (EventHeader) and the Citiroc channel, like the mask applied
+ * by the unpackers, not by the module of the lookup. Boards without a mask entry use no mask.
+ */
+class sabat_hot_channel_detection : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_hot_channel_detection(sabat::category_demand& demand,
+                                         sabat::hot_channel_detector& detector,
+                                         Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , detector(detector)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::EventHeader, SabatCategories::SiPMRaw};
+
+    auto init() -> bool override
+    {
+        demand.require(SabatCategories::EventHeader);
+        demand.require(SabatCategories::SiPMRaw);
+
+        cat_event_header = model()->get_category(SabatCategories::EventHeader);
+        cat_sipm_raw = model()->get_category(SabatCategories::SiPMRaw);
+
+        return reinit();
+    }
+
+    auto reinit() -> bool override
+    {
+        auto channel_mask = sabat::find_container<SabatChannelMask>(*db(), "SabatChannelMask");
+        for (size_t board = 0; board < sabat::hot_channel_detector::n_boards; ++board) {
+            auto row = channel_mask ? sabat::find_row(*channel_mask, static_cast<uint8_t>(board)) : std::nullopt;
+            auto [mask] = row.value_or(std::tuple {uint64_t {0}});
+            detector.set_base_mask(board, mask);
+        }
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (cat_event_header == nullptr or cat_sipm_raw == nullptr or cat_event_header->get_entries() == 0) {
+            return true;
+        }
+
+        const auto board = cat_event_header->get_object<EventHeader>(0)->board;
+        if (board < 0) {
+            return true;
+        }
+
+        auto n_objs = cat_sipm_raw->get_entries();
+        for (int i = 0; i < n_objs; ++i) {
+            auto raw_obj = cat_sipm_raw->get_object<SiPMRaw>(i);
+            detector.add_hit(static_cast<size_t>(board), static_cast<size_t>(raw_obj->channel));
+        }
+
+        detector.end_event();
+
+        return true;
+    }
+
+private:
+    sabat::category_demand& demand;
+    sabat::hot_channel_detector& detector;
+
+    spark::category* cat_event_header {nullptr};
+    spark::category* cat_sipm_raw {nullptr};
+};
@@ -0,0 +1,87 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_rate_monitor.hpp"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Feeds the rate monitor with the trigger timestamp of EventHeader and the channels of the SiPMRaw hits. A hit with
+ * ToT at the end of the 16-bit ToT counter is counted as an overflow. The application writes the monitor at the end of
+ * each output.
+ *
+ * The channels are keyed by the hardware board of the event (EventHeader) and the Citiroc channel, like the hot
+ * channel detection, not by the module of the lookup.
+ */
+class sabat_monitoring : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_monitoring(sabat::category_demand& demand, sabat::rate_monitor& monitor, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+        , monitor(monitor)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::EventHeader, SabatCategories::SiPMRaw};
+
+    static constexpr float tot_overflow {0xffff * 0.5};  ///< saturated ToT [ns]
+
+    auto init() -> bool override
+    {
+        for (auto cat : inputs) {
+            demand.require(cat);
+        }
+
+        cat_event_header = model()->get_category(SabatCategories::EventHeader);
+        cat_sipm_raw = model()->get_category(SabatCategories::SiPMRaw);
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (cat_event_header == nullptr or cat_event_header->get_entries() == 0) {
+            return true;
+        }
+
+        auto header = cat_event_header->get_object<EventHeader>(0);
+        monitor.add_trigger(header->trgts);
+
+        if (cat_sipm_raw == nullptr) {
+            return true;
+        }
+
+        // a negative board is out of the counted boards, its hits count only in the totals
+        const auto board = header->board < 0 ? sabat::rate_monitor::n_boards : static_cast<size_t>(header->board);
+
+        auto n_objs = cat_sipm_raw->get_entries();
+        for (int i = 0; i < n_objs; ++i) {
+            auto raw_obj = cat_sipm_raw->get_object<SiPMRaw>(i);
+            monitor.add_hit(board, static_cast<size_t>(raw_obj->channel), raw_obj->tot >= tot_overflow);
+        }
+
+        return true;
+    }
+
+private:
+    sabat::category_demand& demand;
+    sabat::rate_monitor& monitor;
+
+    spark::category* cat_event_header {nullptr};
+    spark::category* cat_sipm_raw {nullptr};
+};
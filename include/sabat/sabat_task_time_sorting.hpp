@@ -0,0 +1,150 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <spark/core/task.hpp>
+#include <spark/spark.hpp>
+
+#include "sabat/sabat_categories.hpp"
+#include "sabat/sabat_definitions.hpp"
+#include "sabat/sabat_demand.hpp"
+#include "sabat/sabat_parameters.hpp"
+#include "sabat/sabat_time_sort.hpp"
+
+#include <array>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+/**
+ * Orders the SiPMCal hits of the event by ToA and splits them into coincidence windows of the width given by the
+ * SiPMCoincPar container of the run, default_width without it. SiPMTimeOrder holds the hits in time order and
+ * CoincWindow the [begin, end) ranges of SiPMTimeOrder indexes, so the pairs can be searched within windows only. Hits
+ * without ToA (negative or NaN) are not ordered.
+ */
+class sabat_time_sorting : public spark::task
+{
+public:
+    template<typename... Args>
+    explicit sabat_time_sorting(sabat::category_demand& demand, Args&&... args)
+        : task(std::forward<Args>(args)...)
+        , demand(demand)
+    {
+    }
+
+    static constexpr std::array inputs {SabatCategories::SiPMCal};
+    static constexpr std::array outputs {SabatCategories::SiPMTimeOrder, SabatCategories::CoincWindow};
+
+    static constexpr float default_width {10.f};  ///< window width [ns] without SiPMCoincPar
+
+    auto init() -> bool override
+    {
+        cat_sipm_cal = model()->get_category(SabatCategories::SiPMCal);
+
+        if (cat_sipm_cal == nullptr) {
+            spdlog::critical("[{}] No SiPMCal category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_time_order = model()->build_category<SiPMTimeIndex>(SabatCategories::SiPMTimeOrder);
+
+        if (cat_time_order == nullptr) {
+            spdlog::critical("[{}] Cannot build SiPMTimeOrder category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        cat_coinc_window = model()->build_category<CoincWindow>(SabatCategories::CoincWindow);
+
+        if (cat_coinc_window == nullptr) {
+            spdlog::critical("[{}] Cannot build CoincWindow category", __PRETTY_FUNCTION__);
+            return false;
+        }
+
+        demand.add_producer(inputs, outputs);
+
+        return reinit();
+    }
+
+    auto reinit() -> bool override
+    {
+        auto coinc_par = sabat::find_container<SiPMCoincPar>(*db(), "SiPMCoincPar");
+        auto row = coinc_par ? sabat::find_row(*coinc_par, uint8_t {0}) : std::nullopt;
+        if (!row) {
+            spdlog::info("[{}] No SiPMCoincPar, window width {} ns", __PRETTY_FUNCTION__, default_width);
+        }
+
+        std::tie(width) = row.value_or(std::tuple {default_width});
+
+        return true;
+    }
+
+    auto execute() -> bool override
+    {
+        if (!demand.any_required(outputs)) {
+            return true;
+        }
+
+        auto n_objs = cat_sipm_cal->get_entries();
+
+        sorter.clear();
+
+        for (int i = 0; i < n_objs; ++i) {
+            auto cal_obj = cat_sipm_cal->get_object<SiPMCal>(i);
+
+            if (!(cal_obj->toa >= 0)) {  // also NaN
+                continue;
+            }
+
+            if (!sorter.push(cal_obj->toa, static_cast<int16_t>(i))) {
+                spdlog::warn(
+                    "[{}] More than {} hits in event, rest is not sorted", __PRETTY_FUNCTION__, sorter.capacity);
+                break;
+            }
+        }
+
+        sorter.sort();
+
+        auto hits = sorter.sorted();
+        int n_windows {0};
+
+        sabat::split_windows(hits,
+                             width,
+                             [&](size_t begin, size_t end)
+                             {
+                                 for (auto k = begin; k < end; ++k) {
+                                     auto idx_obj = cat_time_order->make_object_unsafe<SiPMTimeIndex>({k});
+                                     idx_obj->cal_index = hits[k].index;
+                                     idx_obj->window = n_windows;
+                                     idx_obj->toa = hits[k].toa;
+                                 }
+
+                                 auto win_obj = cat_coinc_window->make_object_unsafe<CoincWindow>(
+                                     {static_cast<size_t>(n_windows)});
+                                 win_obj->begin = static_cast<int>(begin);
+                                 win_obj->end = static_cast<int>(end);
+                                 win_obj->t_begin = hits[begin].toa;
+                                 win_obj->t_end = hits[end - 1].toa;
+
+                                 n_windows++;
+                             });
+
+        return true;
+    }
+
+private:
+    sabat::category_demand& demand;
+
+    spark::category* cat_sipm_cal {nullptr};
+    spark::category* cat_time_order {nullptr};
+    spark::category* cat_coinc_window {nullptr};
+
+    float width {default_width};  ///< window width of the run [ns]
+
+    sabat::time_sorter<128> sorter;
+};
@@ -0,0 +1,151 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sabat
+{
+
+/**
+ * Thread pool with a job queue per worker. Workers push the jobs they submit to their own queue and take them from the
+ * back, idle workers steal from the front of the other queues. Jobs submitted from outside of the pool go to a shared
+ * queue, which is also served by run_one(), so the submitting thread can help instead of blocking.
+ */
+class work_stealing_pool
+{
+public:
+    using job = std::function<void()>;
+
+    explicit work_stealing_pool(size_t n_workers)
+    {
+        for (size_t i = 0; i <= n_workers; ++i) {
+            queues.push_back(std::make_unique<job_queue>());
+        }
+
+        workers.reserve(n_workers);
+        for (size_t i = 0; i < n_workers; ++i) {
+            workers.emplace_back([this, i](std::stop_token stoken) { work(stoken, i); });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    auto operator=(const work_stealing_pool&) -> work_stealing_pool& = delete;
+
+    ~work_stealing_pool()
+    {
+        for (auto& worker : workers) {
+            worker.request_stop();
+        }
+        wake.notify_all();
+    }
+
+    auto size() const -> size_t { return workers.size(); }
+
+    auto submit(job j) -> void
+    {
+        auto idx = (current_pool == this) ? current_worker : shared_queue();
+
+        pending++;
+        {
+            std::lock_guard lock(queues[idx]->mtx);
+            queues[idx]->jobs.push_back(std::move(j));
+        }
+        {
+            std::lock_guard lock(wake_mtx);
+        }
+        wake.notify_one();
+    }
+
+    /// Run single pending job in the calling thread, returns false if there was none.
+    auto run_one() -> bool
+    {
+        auto j = take((current_pool == this) ? current_worker : shared_queue());
+        if (!j) {
+            return false;
+        }
+        (*j)();
+        return true;
+    }
+
+private:
+    struct job_queue
+    {
+        std::mutex mtx;
+        std::deque<job> jobs;
+    };
+
+    auto shared_queue() const -> size_t { return workers.size(); }
+
+    auto take(size_t own) -> std::optional<job>
+    {
+        {
+            std::lock_guard lock(queues[own]->mtx);
+            if (!queues[own]->jobs.empty()) {
+                auto j = std::move(queues[own]->jobs.back());
+                queues[own]->jobs.pop_back();
+                pending--;
+                return j;
+            }
+        }
+
+        for (size_t k = 1; k < queues.size(); ++k) {
+            auto& victim = *queues[(own + k) % queues.size()];
+            std::lock_guard lock(victim.mtx);
+            if (!victim.jobs.empty()) {
+                auto j = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                pending--;
+                return j;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    auto work(std::stop_token stoken, size_t idx) -> void
+    {
+        current_pool = this;
+        current_worker = idx;
+
+        while (!stoken.stop_requested()) {
+            if (auto j = take(idx)) {
+                (*j)();
+                continue;
+            }
+
+            std::unique_lock lock(wake_mtx);
+            wake.wait(lock, stoken, [this] { return pending > 0; });
+        }
+    }
+
+    static inline thread_local const work_stealing_pool* current_pool {nullptr};
+    static inline thread_local size_t current_worker {0};
+
+    std::vector<std::unique_ptr<job_queue>> queues;  ///< one per worker and the shared one at the end
+    std::atomic<size_t> pending {0};
+
+    std::mutex wake_mtx;
+    std::condition_variable_any wake;
+
+    std::vector<std::jthread> workers;  ///< last member, joined before the queues are destroyed
+};
+
+}  // namespace sabat
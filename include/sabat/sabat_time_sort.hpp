@@ -0,0 +1,97 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace sabat
+{
+
+struct time_key
+{
+    float toa {0};
+    int16_t index {-1};
+};
+
+/**
+ * Fixed capacity buffer of hit times. Sorting is done in place, without any allocation: insertion sort for the
+ * typical small events, std::sort above the threshold.
+ */
+template<size_t N>
+class time_sorter
+{
+public:
+    static constexpr size_t capacity {N};
+    static constexpr size_t insertion_sort_limit {32};
+
+    auto clear() -> void { n_keys = 0; }
+
+    /// Add hit, returns false when the buffer is full.
+    auto push(float toa, int16_t index) -> bool
+    {
+        if (n_keys == N) {
+            return false;
+        }
+        keys[n_keys++] = {toa, index};
+        return true;
+    }
+
+    auto sort() -> void
+    {
+        if (n_keys > insertion_sort_limit) {
+            std::sort(keys.begin(), keys.begin() + n_keys, [](const auto& a, const auto& b) { return a.toa < b.toa; });
+            return;
+        }
+
+        for (size_t i = 1; i < n_keys; ++i) {
+            auto key = keys[i];
+            auto j = i;
+            for (; j > 0 and keys[j - 1].toa > key.toa; --j) {
+                keys[j] = keys[j - 1];
+            }
+            keys[j] = key;
+        }
+    }
+
+    auto sorted() const -> std::span<const time_key> { return {keys.data(), n_keys}; }
+
+    auto size() const -> size_t { return n_keys; }
+
+private:
+    std::array<time_key, N> keys {};
+    size_t n_keys {0};
+};
+
+/**
+ * Split time ordered hits into coincidence windows. A window is opened by the first hit not assigned yet and contains
+ * all following hits within the width from the opening hit. The callback receives the [begin, end) index range.
+ *
+ * \param hits time ordered hits
+ * \param width window width
+ * \param callback called with (begin, end) for each window
+ */
+template<typename Callback>
+auto split_windows(std::span<const time_key> hits, float width, Callback&& callback) -> void
+{
+    size_t begin = 0;
+    while (begin < hits.size()) {
+        auto end = begin + 1;
+        while (end < hits.size() and hits[end].toa - hits[begin].toa <= width) {
+            ++end;
+        }
+        callback(begin, end);
+        begin = end;
+    }
+}
+
+}  // namespace sabat
@@ -17,14 +17,23 @@
 // #pragma link C++ nestedclasses;
 // #pragma link C++ nestedtypedefs;
 
+#pragma link C++ class GeantTrack+;
+#pragma link C++ class GeantSiPMRaw+;
+#pragma link C++ class EventHeader+;
 #pragma link C++ class SiPMRaw+;
 #pragma link C++ class SiPMCal+;
 #pragma link C++ class PhotonHit+;
+#pragma link C++ class SiPMTimeIndex+;
+#pragma link C++ class CoincWindow+;
 
 // containers
 
 #pragma link C++ class SabatLookup+;
 #pragma link C++ class SiPMCalPar+;
+#pragma link C++ class SiPMCoincPar+;
+#pragma link C++ class SabatGeometryPar+;
+#pragma link C++ class SiPMDigiPar+;
+#pragma link C++ class SabatChannelMask+;
 
 // obsolete
 #pragma link C++ class SabatPixelLookup+;
@@ -8,6 +8,7 @@
 
 #include "sabat/citiroc_bin_source.hpp"
 
+#include "sabat/citiroc_bin_decoder.hpp"
 #include "sabat/citiroc_types.hpp"
 #include "sabat/citiroc_utils.hpp"
 
@@ -24,26 +25,6 @@
 namespace spark::citiroc
 {
 
-namespace
-{
-auto read_file_header(std::istream& source) -> types::file_header
-{
-    types::file_header fheader;
-
-    fheader.firmware_ver = std::byteswap(utils::read_n_bytes<uint16_t>(2, source));
-    fheader.janus_rel = std::byteswap(utils::read_n_bytes<uint32_t>(3, source)) >> 8;
-    fheader.board_id = utils::read_n_bytes<uint16_t>(2, source);
-    fheader.run = utils::read_n_bytes<uint16_t>(2, source);
-    fheader.acq_mode = utils::read_n_bytes<uint8_t>(1, source);
-    fheader.e_hists_nbins = utils::read_n_bytes<uint16_t>(2, source);
-    fheader.toa_tot_unit = utils::read_n_bytes<uint8_t>(1, source);
-    fheader.time_lsb = utils::read_n_bytes<uint32_t>(4, source);
-    fheader.run_timestamp = utils::read_n_bytes<uint64_t>(8, source);
-
-    return fheader;
-}
-}  // namespace
-
 auto bin_source::open() -> bool
 {
     if (fheader.firmware_ver > 0) {
@@ -60,7 +41,10 @@ auto bin_source::open() -> bool
 
     spdlog::info("Citiroc bin file open: {:s}", file.string());
 
-    fheader = read_file_header(source);
+    fheader = decoder::read_file_header(source);
+
+    data_offset = static_cast<uint64_t>(source.tellg());
+    event_offset = data_offset;
 
     spdlog::info(
         " Firmware: {:#06x}  Janus: {:#08x}:  Board {:#06x}:  Run {:#06x}:  AcqMode {:#04x} "
@@ -74,24 +58,46 @@ auto bin_source::open() -> bool
 
     spdlog::info("Board ID {:#x} -> vaddr {}", hwid, vaddr);
 
+    if (!mode_unpackers.empty()) {
+        auto it = mode_unpackers.find(fheader.acq_mode);
+        if (it == mode_unpackers.end()) {
+            spdlog::error("Citiroc Acquisition Mode {:#04x} not supported by any unpacker", fheader.acq_mode);
+            close();
+            return false;
+        }
+        mode_unpacker = it->second;
+    }
+
     if (spdlog::get_level() == spdlog::level::debug) {
         spdlog::debug("Number of events in file: {}", get_n_events());
     }
     return true;
 }
 
+auto bin_source::close() -> bool
+{
+    if (source.is_open()) {
+        source.close();
+    }
+
+    fheader = {};
+    mode_unpacker = nullptr;
+    data_offset = 0;
+    event_offset = 0;
+
+    return true;
+}
+
 auto bin_source::read_current_event() -> bool
 {
     spdlog::debug("Read Citiroc event {} for vadrr = {}", get_current_event(), vaddr);
 
-    auto* unp = get_unpacker(vaddr);
+    auto* unp = mode_unpacker ? mode_unpacker : get_unpacker(vaddr);
+
+    event_offset = static_cast<uint64_t>(source.tellg());
 
     spdlog::debug("Unpacker = {:p} for {} event {}", (void*)unp, vaddr, get_current_event());
     return unp->execute(get_current_event(), get_current_event(), vaddr, source, 0);
-
-    return true;
-
-    return source.operator bool();
 }
 
 auto bin_source::get_n_events() -> int64_t
@@ -100,7 +106,7 @@ auto bin_source::get_n_events() -> int64_t
 
     source.seekg(0);
 
-    read_file_header(source);
+    decoder::read_file_header(source);
 
     int64_t nevents {0};
 
@@ -129,6 +135,39 @@ auto bin_source::get_n_events() -> int64_t
     return nevents;
 }
 
-auto bin_source::skip_to_event(int64_t) -> void {}
+auto bin_source::skip_to_event(int64_t new_event) -> bool
+{
+    if (!seek_to_offset(data_offset)) {
+        return false;
+    }
+
+    for (int64_t i = 0; i < new_event; ++i) {
+        auto evsize = utils::read_n_bytes<uint16_t>(2, source);
+        if (!source or evsize < 2) {
+            spdlog::error("Cannot skip to event {}, file {} has {} events", new_event, file.string(), i);
+            source.clear();
+            return false;
+        }
+
+        source.seekg(evsize - 2, std::ios::cur);
+    }
+
+    event_offset = static_cast<uint64_t>(source.tellg());
+
+    return static_cast<bool>(source);
+}
+
+auto bin_source::seek_to_offset(uint64_t offset) -> bool
+{
+    if (!source.is_open() or offset < data_offset) {
+        return false;
+    }
+
+    source.clear();
+    source.seekg(static_cast<std::streamoff>(offset));
+    event_offset = offset;
+
+    return static_cast<bool>(source);
+}
 
 }  // namespace spark::citiroc
@@ -0,0 +1,399 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_checkpoint.hpp"
+
+#include "sabat/sabat_output.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TKey.h>
+#include <TTree.h>
+#include <spdlog/spdlog.h>
+
+namespace sabat
+{
+
+auto write_checkpoint(const std::filesystem::path& filepath, const checkpoint& ckpt) -> bool
+{
+    auto tmp = filepath;
+    tmp += ".tmp";
+
+    {
+        std::ofstream out(tmp);
+        out << "input " << ckpt.input.string() << '\n'
+            << "offset " << ckpt.offset << '\n'
+            << "event " << ckpt.event << '\n'
+            << "entries " << ckpt.entries << '\n'
+            << "run " << ckpt.run << '\n';
+        out.flush();
+
+        if (!out) {
+            spdlog::error("[{}] Cannot write checkpoint {}", __PRETTY_FUNCTION__, tmp.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, filepath, ec);
+    if (ec) {
+        spdlog::error("[{}] Cannot write checkpoint {}: {}", __PRETTY_FUNCTION__, filepath.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+auto read_checkpoint(const std::filesystem::path& filepath) -> std::optional<checkpoint>
+{
+    std::ifstream in(filepath);
+    if (!in) {
+        return std::nullopt;
+    }
+
+    checkpoint ckpt;
+    int fields {0};
+
+    std::string key;
+    while (in >> key) {
+        if (key == "input") {
+            in >> std::ws;
+            std::string input;
+            std::getline(in, input);
+            ckpt.input = input;
+        } else if (key == "offset") {
+            in >> ckpt.offset;
+        } else if (key == "event") {
+            in >> ckpt.event;
+        } else if (key == "entries") {
+            in >> ckpt.entries;
+        } else if (key == "run") {
+            in >> ckpt.run;
+        } else {
+            spdlog::error("[{}] Unknown key {} in checkpoint {}", __PRETTY_FUNCTION__, key, filepath.string());
+            return std::nullopt;
+        }
+
+        if (!in and !in.eof()) {
+            spdlog::error("[{}] Invalid value of {} in checkpoint {}", __PRETTY_FUNCTION__, key, filepath.string());
+            return std::nullopt;
+        }
+        fields++;
+    }
+
+    if (fields != 5) {
+        spdlog::error("[{}] Incomplete checkpoint {}", __PRETTY_FUNCTION__, filepath.string());
+        return std::nullopt;
+    }
+
+    return ckpt;
+}
+
+static_assert(std::is_trivially_copyable_v<event_index_record>);
+
+auto append_checkpoint_index(const std::filesystem::path& filepath, std::span<const event_index_record> records)
+    -> bool
+{
+    std::ofstream out(filepath, std::ios::binary | std::ios::app);
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size_bytes()));
+    out.flush();
+
+    if (!out) {
+        spdlog::error("[{}] Cannot write checkpoint index {}", __PRETTY_FUNCTION__, filepath.string());
+        return false;
+    }
+
+    return true;
+}
+
+auto restore_checkpoint_index(const std::filesystem::path& filepath, size_t n)
+    -> std::optional<std::vector<event_index_record>>
+{
+    std::vector<event_index_record> records(n);
+
+    {
+        std::ifstream in(filepath, std::ios::binary);
+        in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(n * sizeof(event_index_record)));
+
+        if (!in) {
+            return std::nullopt;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::resize_file(filepath, n * sizeof(event_index_record), ec);
+    if (ec) {
+        spdlog::error("[{}] Cannot cut checkpoint index {}: {}", __PRETTY_FUNCTION__, filepath.string(), ec.message());
+        return std::nullopt;
+    }
+
+    return records;
+}
+
+auto save_output(const std::filesystem::path& filepath, std::string_view tree_name) -> std::optional<int64_t>
+{
+    auto* tree = find_output_tree(filepath, tree_name);
+    if (tree == nullptr) {
+        return std::nullopt;
+    }
+
+    tree->AutoSave("SaveSelf");
+
+    return tree->GetEntries();
+}
+
+auto merge_outputs(std::span<const std::filesystem::path> parts,
+                   const std::filesystem::path& target,
+                   std::string_view tree_name,
+                   int64_t max_entries) -> std::optional<int64_t>
+{
+    auto tmp = target;
+    tmp += ".merge";
+
+    std::unique_ptr<TFile> out {TFile::Open(tmp.c_str(), "RECREATE")};
+    if (!out or out->IsZombie()) {
+        spdlog::error("[{}] Cannot create {}", __PRETTY_FUNCTION__, tmp.string());
+        return std::nullopt;
+    }
+
+    struct merged_tree
+    {
+        TTree* tree {nullptr};
+        int64_t remaining {0};
+        size_t n_parts {0};
+    };
+
+    std::map<std::string, merged_tree, std::less<>> trees;
+    std::set<std::string, std::less<>> copied;
+
+    for (const auto& part : parts) {
+        std::unique_ptr<TFile> in {TFile::Open(part.c_str(), "READ")};
+        if (!in or in->IsZombie()) {
+            spdlog::error("[{}] Cannot open {}", __PRETTY_FUNCTION__, part.string());
+            return std::nullopt;
+        }
+
+        if (in->Get<TTree>(std::string(tree_name).c_str()) == nullptr) {
+            spdlog::error("[{}] No tree {} in {}", __PRETTY_FUNCTION__, tree_name, part.string());
+            return std::nullopt;
+        }
+
+        std::set<std::string, std::less<>> seen;
+
+        for (auto* obj : *in->GetListOfKeys()) {
+            auto* key = static_cast<TKey*>(obj);
+            const std::string name = key->GetName();
+
+            if (!seen.insert(name).second) {
+                continue;  // older cycle
+            }
+
+            auto* cls = TClass::GetClass(key->GetClassName());
+
+            if (cls != nullptr and cls->InheritsFrom(TTree::Class())) {
+                auto* tree = in->Get<TTree>(name.c_str());
+                auto& [merged, remaining, n_parts] = trees[name];
+
+                if (merged == nullptr) {
+                    out->cd();
+                    merged = tree->CloneTree(0);
+                    remaining = max_entries;
+                }
+
+                const auto n_entries =
+                    remaining < 0 ? tree->GetEntries() : std::min<int64_t>(remaining, tree->GetEntries());
+
+                merged->CopyEntries(tree, n_entries);
+
+                if (remaining >= 0) {
+                    remaining -= n_entries;
+                }
+
+                merged->ResetBranchAddresses();
+                n_parts++;
+                continue;
+            }
+
+            if (cls != nullptr and cls->InheritsFrom(TDirectory::Class())) {
+                spdlog::warn("[{}] Directory {} of {} not merged", __PRETTY_FUNCTION__, name, part.string());
+                continue;
+            }
+
+            if (!copied.insert(name).second) {
+                continue;  // taken from the first part
+            }
+
+            std::unique_ptr<TObject> copy {key->ReadObj()};
+            if (copy) {
+                out->cd();
+                copy->Write(name.c_str(), TObject::kOverwrite);
+            }
+        }
+    }
+
+    auto it = trees.find(tree_name);
+    if (it == trees.end()) {
+        return std::nullopt;
+    }
+
+    const auto entries = it->second.tree->GetEntries();
+
+    out->cd();
+    for (auto& [name, merged] : trees) {
+        if (merged.n_parts != parts.size()) {
+            spdlog::warn("[{}] Tree {} is not in all parts, not merged", __PRETTY_FUNCTION__, name);
+            delete merged.tree;
+            continue;
+        }
+        merged.tree->Write("", TObject::kOverwrite);
+    }
+    out->Close();
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        spdlog::error("[{}] Cannot replace {}: {}", __PRETTY_FUNCTION__, target.string(), ec.message());
+        return std::nullopt;
+    }
+
+    return entries;
+}
+
+auto append_output(const std::filesystem::path& target,
+                   const std::filesystem::path& part,
+                   std::string_view tree_name,
+                   int64_t max_entries) -> std::optional<int64_t>
+{
+    std::unique_ptr<TFile> out {TFile::Open(target.c_str(), "UPDATE")};
+    if (!out or out->IsZombie()) {
+        spdlog::error("[{}] Cannot open {} for update", __PRETTY_FUNCTION__, target.string());
+        return std::nullopt;
+    }
+
+    std::unique_ptr<TFile> in {TFile::Open(part.c_str(), "READ")};
+    if (!in or in->IsZombie()) {
+        spdlog::error("[{}] Cannot open {}", __PRETTY_FUNCTION__, part.string());
+        return std::nullopt;
+    }
+
+    const std::string main_tree(tree_name);
+    if (in->Get<TTree>(main_tree.c_str()) == nullptr or out->Get<TTree>(main_tree.c_str()) == nullptr) {
+        spdlog::error(
+            "[{}] No tree {} in {} or {}", __PRETTY_FUNCTION__, tree_name, target.string(), part.string());
+        return std::nullopt;
+    }
+
+    std::set<std::string, std::less<>> seen;
+
+    for (auto* obj : *in->GetListOfKeys()) {
+        auto* key = static_cast<TKey*>(obj);
+        const std::string name = key->GetName();
+
+        if (!seen.insert(name).second) {
+            continue;  // older cycle
+        }
+
+        auto* cls = TClass::GetClass(key->GetClassName());
+
+        if (cls != nullptr and cls->InheritsFrom(TTree::Class())) {
+            auto* tree = in->Get<TTree>(name.c_str());
+            auto* appended = out->Get<TTree>(name.c_str());
+
+            if (appended == nullptr) {
+                spdlog::warn("[{}] Tree {} is not in {}, not appended", __PRETTY_FUNCTION__, name, target.string());
+                continue;
+            }
+
+            auto n_entries = tree->GetEntries();
+            if (max_entries >= 0) {
+                n_entries = std::clamp<int64_t>(max_entries - appended->GetEntries(), 0, n_entries);
+            }
+
+            if (n_entries > 0) {
+                out->cd();
+                appended->CopyEntries(tree, n_entries, "", true);
+                appended->Write("", TObject::kOverwrite);
+            }
+            continue;
+        }
+
+        if (cls != nullptr and cls->InheritsFrom(TDirectory::Class())) {
+            spdlog::warn("[{}] Directory {} of {} not appended", __PRETTY_FUNCTION__, name, part.string());
+            continue;
+        }
+
+        if (out->GetKey(name.c_str()) != nullptr) {
+            continue;  // kept from the target
+        }
+
+        std::unique_ptr<TObject> copy {key->ReadObj()};
+        if (copy) {
+            out->cd();
+            copy->Write(name.c_str(), TObject::kOverwrite);
+        }
+    }
+
+    const auto entries = out->Get<TTree>(main_tree.c_str())->GetEntries();
+    out->Close();
+
+    return entries;
+}
+
+auto cut_output(const std::filesystem::path& target, std::string_view tree_name, int64_t max_entries)
+    -> std::optional<int64_t>
+{
+    std::unique_ptr<TFile> out {TFile::Open(target.c_str(), "UPDATE")};
+    if (!out or out->IsZombie()) {
+        spdlog::error("[{}] Cannot open {} for update", __PRETTY_FUNCTION__, target.string());
+        return std::nullopt;
+    }
+
+    auto* tree = out->Get<TTree>(std::string(tree_name).c_str());
+    if (tree == nullptr) {
+        spdlog::error("[{}] No tree {} in {}", __PRETTY_FUNCTION__, tree_name, target.string());
+        return std::nullopt;
+    }
+
+    if (tree->GetEntries() > max_entries) {
+        spdlog::info("[{}] Cutting {} of {} from {} back to {} entries",
+                     __PRETTY_FUNCTION__,
+                     tree_name,
+                     target.string(),
+                     tree->GetEntries(),
+                     max_entries);
+
+        out->cd();
+        auto* cut = tree->CloneTree(0);
+        cut->CopyEntries(tree, max_entries);
+        cut->FlushBaskets();
+        cut->ResetBranchAddresses();
+
+        tree->Delete("all");  // the baskets and the header of the old tree, deletes the object too
+        cut->Write();
+        tree = cut;
+    }
+
+    const auto entries = tree->GetEntries();
+    out->Close();
+
+    return entries;
+}
+
+}  // namespace sabat
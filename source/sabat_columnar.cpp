@@ -0,0 +1,338 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_columnar.hpp"
+
+#include "sabat/sabat_categories.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#ifdef SABAT_HAS_ARROW
+#    include <arrow/api.h>
+#    include <arrow/io/file.h>
+#    include <arrow/ipc/writer.h>
+#    include <parquet/arrow/writer.h>
+#endif
+
+namespace sabat
+{
+
+namespace
+{
+
+constexpr std::array<std::pair<std::string_view, columnar_format>, 2> format_names {{
+    {"parquet", columnar_format::parquet},
+    {"ipc", columnar_format::arrow_ipc},
+}};
+
+}  // namespace
+
+auto columnar_format_from_name(std::string_view name) -> std::optional<columnar_format>
+{
+    for (const auto& [format_name, format] : format_names) {
+        if (format_name == name) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+auto columnar_extension(columnar_format format) -> std::string_view
+{
+    return format == columnar_format::parquet ? ".parquet" : ".arrows";
+}
+
+#ifdef SABAT_HAS_ARROW
+
+namespace
+{
+
+/// Builder of a list<struct> column, with the field builders resolved once.
+struct list_column
+{
+    explicit list_column(std::shared_ptr<arrow::DataType> type)
+    {
+        auto result = arrow::MakeBuilder(type);
+        builder = std::move(result).ValueOrDie();
+        list = static_cast<arrow::ListBuilder*>(builder.get());
+        items = static_cast<arrow::StructBuilder*>(list->value_builder());
+    }
+
+    template<typename Builder>
+    auto field(int i) -> Builder*
+    {
+        return static_cast<Builder*>(items->field_builder(i));
+    }
+
+    std::unique_ptr<arrow::ArrayBuilder> builder;
+    arrow::ListBuilder* list {nullptr};
+    arrow::StructBuilder* items {nullptr};
+};
+
+auto list_of(arrow::FieldVector fields) -> std::shared_ptr<arrow::DataType>
+{
+    return arrow::list(arrow::struct_(std::move(fields)));
+}
+
+}  // namespace
+
+struct columnar_writer::impl
+{
+    impl()
+        : sipm_raw(list_of({arrow::field("board", arrow::int32()),
+                            arrow::field("channel", arrow::int32()),
+                            arrow::field("sipm", arrow::int32()),
+                            arrow::field("toa", arrow::float32()),
+                            arrow::field("tot", arrow::float32()),
+                            arrow::field("lgpha", arrow::int32()),
+                            arrow::field("hgpha", arrow::int32())}))
+        , sipm_cal(list_of({arrow::field("board", arrow::int32()),
+                            arrow::field("channel", arrow::int32()),
+                            arrow::field("toa", arrow::float32()),
+                            arrow::field("energy", arrow::float32())}))
+        , photon_hit(list_of({arrow::field("board", arrow::int32()),
+                              arrow::field("x", arrow::float32()),
+                              arrow::field("y", arrow::float32()),
+                              arrow::field("energy", arrow::float32()),
+                              arrow::field("mult", arrow::int32())}))
+    {
+        schema = arrow::schema({arrow::field("trgts", arrow::uint64()),
+                                arrow::field("trgid", arrow::uint64()),
+                                arrow::field("sipm_raw", sipm_raw.builder->type()),
+                                arrow::field("sipm_cal", sipm_cal.builder->type()),
+                                arrow::field("photon_hit", photon_hit.builder->type())});
+    }
+
+    auto check(const arrow::Status& st) -> void
+    {
+        if (!st.ok() and status.ok()) {
+            status = st;
+        }
+    }
+
+    auto flush() -> bool
+    {
+        if (rows == 0) {
+            return status.ok();
+        }
+
+        std::vector<std::shared_ptr<arrow::Array>> columns(5);
+        check(trgts.Finish(&columns[0]));
+        check(trgid.Finish(&columns[1]));
+        check(sipm_raw.builder->Finish(&columns[2]));
+        check(sipm_cal.builder->Finish(&columns[3]));
+        check(photon_hit.builder->Finish(&columns[4]));
+
+        if (status.ok() and parquet_writer) {
+            // WriteRecordBatch() would append to one buffered row group, holding the whole file in memory
+            auto table = arrow::Table::Make(schema, std::move(columns), rows);
+            check(parquet_writer->WriteTable(*table, rows));
+        } else if (status.ok()) {
+            auto batch = arrow::RecordBatch::Make(schema, rows, std::move(columns));
+            check(ipc_writer->WriteRecordBatch(*batch));
+        }
+
+        rows = 0;
+
+        if (!status.ok()) {
+            spdlog::error("[{}] Arrow export failed: {}", __PRETTY_FUNCTION__, status.ToString());
+        }
+
+        return status.ok();
+    }
+
+    std::shared_ptr<arrow::Schema> schema;
+    std::shared_ptr<arrow::io::FileOutputStream> file;
+    std::unique_ptr<parquet::arrow::FileWriter> parquet_writer;
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc_writer;
+
+    arrow::UInt64Builder trgts;
+    arrow::UInt64Builder trgid;
+    list_column sipm_raw;
+    list_column sipm_cal;
+    list_column photon_hit;
+
+    arrow::Status status;
+    int64_t rows {0};
+    size_t batch_events {0};
+};
+
+columnar_writer::columnar_writer()
+    : d(std::make_unique<impl>())
+{
+}
+
+auto columnar_writer::open(const columnar_options& options) -> bool
+{
+    close();
+
+    d->status = arrow::Status::OK();
+    d->batch_events = std::max<size_t>(options.batch_events, 1);
+
+    auto file = arrow::io::FileOutputStream::Open(options.path.string());
+    if (!file.ok()) {
+        spdlog::error("[{}] Cannot open {}: {}", __PRETTY_FUNCTION__, options.path.string(), file.status().ToString());
+        return false;
+    }
+    d->file = *file;
+
+    if (options.format == columnar_format::parquet) {
+        auto writer = parquet::arrow::FileWriter::Open(*d->schema, arrow::default_memory_pool(), d->file);
+        if (!writer.ok()) {
+            spdlog::error("[{}] Cannot create Parquet writer: {}", __PRETTY_FUNCTION__, writer.status().ToString());
+            d->file.reset();
+            return false;
+        }
+        d->parquet_writer = std::move(writer).ValueOrDie();
+    } else {
+        auto writer = arrow::ipc::MakeStreamWriter(d->file, d->schema);
+        if (!writer.ok()) {
+            spdlog::error("[{}] Cannot create IPC writer: {}", __PRETTY_FUNCTION__, writer.status().ToString());
+            d->file.reset();
+            return false;
+        }
+        d->ipc_writer = *writer;
+    }
+
+    return true;
+}
+
+auto columnar_writer::close() -> bool
+{
+    if (!is_open()) {
+        return true;
+    }
+
+    auto ok = d->flush();
+
+    if (d->parquet_writer) {
+        d->check(d->parquet_writer->Close());
+        d->parquet_writer.reset();
+    }
+    if (d->ipc_writer) {
+        d->check(d->ipc_writer->Close());
+        d->ipc_writer.reset();
+    }
+    d->check(d->file->Close());
+    d->file.reset();
+
+    return ok and d->status.ok();
+}
+
+auto columnar_writer::is_open() const -> bool
+{
+    return d and d->file != nullptr;
+}
+
+auto columnar_writer::begin_event(uint64_t trgts, uint64_t trgid) -> void
+{
+    d->check(d->trgts.Append(trgts));
+    d->check(d->trgid.Append(trgid));
+    d->check(d->sipm_raw.list->Append());
+    d->check(d->sipm_cal.list->Append());
+    d->check(d->photon_hit.list->Append());
+}
+
+auto columnar_writer::append(const SiPMRaw& obj) -> void
+{
+    auto& col = d->sipm_raw;
+    d->check(col.items->Append());
+    d->check(col.field<arrow::Int32Builder>(0)->Append(obj.board));
+    d->check(col.field<arrow::Int32Builder>(1)->Append(obj.channel));
+    d->check(col.field<arrow::Int32Builder>(2)->Append(obj.sipm));
+    d->check(col.field<arrow::FloatBuilder>(3)->Append(obj.toa));
+    d->check(col.field<arrow::FloatBuilder>(4)->Append(obj.tot));
+    d->check(col.field<arrow::Int32Builder>(5)->Append(obj.lgpha));
+    d->check(col.field<arrow::Int32Builder>(6)->Append(obj.hgpha));
+}
+
+auto columnar_writer::append(const SiPMCal& obj) -> void
+{
+    auto& col = d->sipm_cal;
+    d->check(col.items->Append());
+    d->check(col.field<arrow::Int32Builder>(0)->Append(obj.board));
+    d->check(col.field<arrow::Int32Builder>(1)->Append(obj.channel));
+    d->check(col.field<arrow::FloatBuilder>(2)->Append(obj.toa));
+    d->check(col.field<arrow::FloatBuilder>(3)->Append(obj.energy));
+}
+
+auto columnar_writer::append(const PhotonHit& obj) -> void
+{
+    auto& col = d->photon_hit;
+    d->check(col.items->Append());
+    d->check(col.field<arrow::Int32Builder>(0)->Append(obj.board));
+    d->check(col.field<arrow::FloatBuilder>(1)->Append(obj.x));
+    d->check(col.field<arrow::FloatBuilder>(2)->Append(obj.y));
+    d->check(col.field<arrow::FloatBuilder>(3)->Append(obj.energy));
+    d->check(col.field<arrow::Int32Builder>(4)->Append(obj.mult));
+}
+
+auto columnar_writer::end_event() -> bool
+{
+    if (++d->rows >= static_cast<int64_t>(d->batch_events)) {
+        return d->flush();
+    }
+    return d->status.ok();
+}
+
+#else
+
+struct columnar_writer::impl
+{
+};
+
+columnar_writer::columnar_writer() = default;
+
+auto columnar_writer::open(const columnar_options& /*options*/) -> bool
+{
+    spdlog::error("[{}] Built without Arrow support, configure with SABAT_WITH_ARROW=ON", __PRETTY_FUNCTION__);
+    return false;
+}
+
+auto columnar_writer::close() -> bool
+{
+    return true;
+}
+
+auto columnar_writer::is_open() const -> bool
+{
+    return false;
+}
+
+auto columnar_writer::begin_event(uint64_t /*trgts*/, uint64_t /*trgid*/) -> void {}
+
+auto columnar_writer::append(const SiPMRaw& /*obj*/) -> void {}
+
+auto columnar_writer::append(const SiPMCal& /*obj*/) -> void {}
+
+auto columnar_writer::append(const PhotonHit& /*obj*/) -> void {}
+
+auto columnar_writer::end_event() -> bool
+{
+    return true;
+}
+
+#endif
+
+columnar_writer::columnar_writer(columnar_writer&&) noexcept = default;
+
+auto columnar_writer::operator=(columnar_writer&&) noexcept -> columnar_writer& = default;
+
+columnar_writer::~columnar_writer()
+{
+    close();
+}
+
+}  // namespace sabat
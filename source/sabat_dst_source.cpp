@@ -0,0 +1,93 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_dst_source.hpp"
+
+#include "sabat/sabat_dst_format.hpp"
+
+#include <fstream>
+#include <ios>
+
+#include <spdlog/spdlog.h>
+
+namespace sabat::dst
+{
+
+auto dst_source::open() -> bool
+{
+    if (is_open) {
+        return true;  // already open
+    }
+
+    source = std::ifstream(file, std::ios_base::binary);
+
+    if (!source) {
+        spdlog::critical("Invalid source {}", file.string());
+        return false;
+    }
+
+    auto file_header = read_file_header(source, version);
+    if (!file_header) {
+        spdlog::critical("{} is not a SABAT DST file", file.string());
+        source.close();
+        return false;
+    }
+
+    fheader = *file_header;
+
+    const auto frames_begin = source.tellg();
+    source.seekg(0, std::ios_base::end);
+    remaining = static_cast<uint64_t>(source.tellg() - frames_begin);
+    source.seekg(frames_begin);
+
+    is_open = true;
+
+    if (auto* unp = dynamic_cast<dst_unpacker*>(get_unpacker(0x0000))) {
+        unp->set_format_version(version);
+    }
+
+    spdlog::info("Sabat DST file open: {:s}  Version {}  Run {:#06x}  AcqMode {:#04x}",
+                 file.string(),
+                 version,
+                 fheader.run,
+                 fheader.acq_mode);
+
+    return true;
+}
+
+auto dst_source::close() -> bool
+{
+    if (source.is_open()) {
+        source.close();
+    }
+
+    fheader = {};
+    remaining = 0;
+    is_open = false;
+
+    return true;
+}
+
+auto dst_source::read_current_event() -> bool
+{
+    if (remaining == 0) {
+        return false;  // end of data
+    }
+
+    auto length = read_frame_size(source, remaining);
+    if (!length) {
+        spdlog::error("Event frame cut short or past the end of {}", file.string());
+        return false;
+    }
+
+    auto* unp = get_unpacker(0x0000);
+
+    return unp->execute(get_current_event(), get_current_event(), 0x0000, source, *length);
+}
+
+}  // namespace sabat::dst
@@ -0,0 +1,108 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_event_index.hpp"
+
+#include <memory>
+#include <string>
+
+#include <TEntryList.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <spdlog/spdlog.h>
+
+namespace sabat
+{
+
+auto write_event_index(const std::filesystem::path& filepath, std::span<const event_index_record> records) -> bool
+{
+    std::unique_ptr<TFile> file {TFile::Open(filepath.c_str(), "UPDATE")};
+    if (!file or file->IsZombie()) {
+        spdlog::error("[{}] Cannot open {} for the event index", __PRETTY_FUNCTION__, filepath.string());
+        return false;
+    }
+
+    event_index_record rec;
+
+    TTree tree(std::string(event_index_tree).c_str(), "SABAT event index");
+    tree.SetDirectory(file.get());
+    tree.Branch("trgts", &rec.trgts, "trgts/l");
+    tree.Branch("mult", &rec.multiplicity, "mult/i");
+    tree.Branch("energy", &rec.energy, "energy/F");
+
+    for (const auto& r : records) {
+        rec = r;
+        tree.Fill();
+    }
+
+    tree.Write("", TObject::kOverwrite);
+    tree.SetDirectory(nullptr);
+
+    file->Close();
+
+    return true;
+}
+
+auto event_index::open(const std::filesystem::path& filepath) -> bool
+{
+    records.clear();
+    file = filepath;
+
+    std::unique_ptr<TFile> input {TFile::Open(filepath.c_str(), "READ")};
+    if (!input or input->IsZombie()) {
+        return false;
+    }
+
+    auto* tree = input->Get<TTree>(std::string(event_index_tree).c_str());
+    if (tree == nullptr) {
+        spdlog::warn("[{}] No event index in {}", __PRETTY_FUNCTION__, filepath.string());
+        return false;
+    }
+
+    event_index_record rec;
+    tree->SetBranchAddress("trgts", &rec.trgts);
+    tree->SetBranchAddress("mult", &rec.multiplicity);
+    tree->SetBranchAddress("energy", &rec.energy);
+
+    const auto n_entries = tree->GetEntries();
+    records.reserve(static_cast<size_t>(n_entries));
+    for (Long64_t i = 0; i < n_entries; ++i) {
+        tree->GetEntry(i);
+        records.push_back(rec);
+    }
+
+    tree->ResetBranchAddresses();
+
+    return true;
+}
+
+auto event_index::select(const event_selection& selection) const -> std::vector<int64_t>
+{
+    std::vector<int64_t> entries;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (selection.accepts(records[i])) {
+            entries.push_back(static_cast<int64_t>(i));
+        }
+    }
+    return entries;
+}
+
+auto event_index::make_entry_list(const event_selection& selection, std::string_view tree_name) const
+    -> std::unique_ptr<TEntryList>
+{
+    auto list = std::make_unique<TEntryList>("sabat_selection", "", std::string(tree_name).c_str(), file.c_str());
+    list->SetDirectory(nullptr);
+
+    for (auto entry : select(selection)) {
+        list->Enter(entry);
+    }
+
+    return list;
+}
+
+}  // namespace sabat
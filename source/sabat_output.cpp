@@ -0,0 +1,155 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_output.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <Compression.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <TVirtualMutex.h>
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+namespace sabat
+{
+
+namespace
+{
+
+using algorithm = ROOT::RCompressionSetting::EAlgorithm;
+
+constexpr std::array<std::pair<std::string_view, int>, 4> algorithm_names {{
+    {"zlib", algorithm::kZLIB},
+    {"lzma", algorithm::kLZMA},
+    {"lz4", algorithm::kLZ4},
+    {"zstd", algorithm::kZSTD},
+}};
+
+auto algorithm_name(int algo) -> std::string_view
+{
+    for (const auto& [name, value] : algorithm_names) {
+        if (value == algo) {
+            return name;
+        }
+    }
+    return "default";
+}
+
+}  // namespace
+
+auto output_options::describe() const -> std::string
+{
+    return fmt::format("compression {}:{}, basket {}, autoflush {}, io threads {}",
+                       algorithm_name(compression_algorithm),
+                       compression_level < 0 ? std::string("default") : std::to_string(compression_level),
+                       basket_size > 0 ? std::to_string(basket_size) : std::string("default"),
+                       auto_flush != 0 ? std::to_string(auto_flush) : std::string("default"),
+                       io_threads);
+}
+
+auto compression_algorithm_from_name(std::string_view name) -> std::optional<int>
+{
+    for (const auto& [algo_name, value] : algorithm_names) {
+        if (algo_name == name) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+auto find_output_tree(const std::filesystem::path& filepath, std::string_view tree_name) -> TTree*
+{
+    TFile* file {nullptr};
+    {
+        R__LOCKGUARD(gROOTMutex);
+        file = dynamic_cast<TFile*>(gROOT->GetListOfFiles()->FindObject(filepath.c_str()));
+    }
+
+    if (file == nullptr) {
+        spdlog::error("[{}] Output file {} is not open", __PRETTY_FUNCTION__, filepath.string());
+        return nullptr;
+    }
+
+    auto* tree = file->Get<TTree>(std::string(tree_name).c_str());
+    if (tree == nullptr) {
+        spdlog::error("[{}] No tree {} in {}", __PRETTY_FUNCTION__, tree_name, filepath.string());
+        return nullptr;
+    }
+
+    return tree;
+}
+
+auto apply_output_options(const std::filesystem::path& filepath, std::string_view tree_name, const output_options& opts)
+    -> bool
+{
+    auto* tree = find_output_tree(filepath, tree_name);
+    if (tree == nullptr) {
+        return false;
+    }
+
+    auto* file = tree->GetCurrentFile();
+
+    if (opts.compression_algorithm > 0 or opts.compression_level >= 0) {
+        const auto current = file->GetCompressionSettings();
+        const auto algo = opts.compression_algorithm > 0 ? opts.compression_algorithm : current / 100;
+        const auto level = opts.compression_level >= 0 ? opts.compression_level : current % 100;
+        const auto settings = algo * 100 + level;
+
+        file->SetCompressionSettings(settings);
+        for (auto* branch : TRangeDynCast<TBranch>(tree->GetListOfBranches())) {
+            if (branch != nullptr) {
+                branch->SetCompressionSettings(settings);
+            }
+        }
+    }
+
+    if (opts.basket_size > 0) {
+        tree->SetBasketSize("*", opts.basket_size);
+    }
+
+    if (opts.auto_flush != 0) {
+        tree->SetAutoFlush(opts.auto_flush);
+    }
+
+    tree->SetImplicitMT(opts.io_threads > 0);
+
+    return true;
+}
+
+auto read_output_stats(const std::filesystem::path& filepath, std::string_view tree_name) -> std::optional<output_stats>
+{
+    std::unique_ptr<TFile> file {TFile::Open(filepath.c_str(), "READ")};
+    if (!file or file->IsZombie()) {
+        return std::nullopt;
+    }
+
+    auto* tree = file->Get<TTree>(std::string(tree_name).c_str());
+    if (tree == nullptr) {
+        return std::nullopt;
+    }
+
+    output_stats stats;
+    stats.entries = tree->GetEntries();
+    stats.tot_bytes = tree->GetTotBytes();
+    stats.zip_bytes = tree->GetZipBytes();
+
+    std::error_code ec;
+    stats.file_size = std::filesystem::file_size(filepath, ec);
+
+    return stats;
+}
+
+}  // namespace sabat
@@ -0,0 +1,144 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+#include "sabat/sabat_sim_source.hpp"
+
+#include "sabat/citiroc_bin_decoder.hpp"
+#include "sabat/sabat_dst_format.hpp"
+#include "sabat/sabat_sim_format.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <system_error>
+
+#include <spdlog/spdlog.h>
+
+namespace sabat::sim
+{
+
+auto sim_source::open() -> bool
+{
+    if (is_open) {
+        return true;  // already open
+    }
+
+    source = std::ifstream(file, std::ios_base::binary);
+
+    if (!source) {
+        spdlog::critical("Invalid source {}", file.string());
+        return false;
+    }
+
+    auto run = read_file_header(source);
+    if (!run) {
+        spdlog::critical("{} is not a SABAT simulation file", file.string());
+        source.close();
+        return false;
+    }
+
+    fheader = {};
+    fheader.run = *run;
+    fheader.acq_mode = spark::citiroc::acq_modes::spect_timing;
+
+    if (range_begin > static_cast<uint64_t>(source.tellg())) {
+        source.seekg(static_cast<std::streamoff>(range_begin));
+    }
+
+    const auto frames_begin = source.tellg();
+    source.seekg(0, std::ios_base::end);
+    remaining = static_cast<uint64_t>(std::max<std::streamoff>(source.tellg() - frames_begin, 0));
+    source.seekg(frames_begin);
+
+    is_open = true;
+
+    if (range_begin > 0 or range_end != std::numeric_limits<uint64_t>::max()) {
+        spdlog::info("Sabat simulation file open: {:s}  Run {:#06x}  Bytes {:d}-{:d}",
+                     file.string(),
+                     fheader.run,
+                     range_begin,
+                     range_end);
+    } else {
+        spdlog::info("Sabat simulation file open: {:s}  Run {:#06x}", file.string(), fheader.run);
+    }
+
+    return true;
+}
+
+auto sim_source::close() -> bool
+{
+    if (source.is_open()) {
+        source.close();
+    }
+
+    fheader = {};
+    remaining = 0;
+    is_open = false;
+
+    return true;
+}
+
+auto sim_source::read_current_event() -> bool
+{
+    const auto offset = source.tellg();
+    if (offset < 0 or static_cast<uint64_t>(offset) >= range_end or remaining == 0) {
+        return false;  // end of the range or of data
+    }
+
+    auto length = dst::read_frame_size(source, remaining);
+    if (!length) {
+        spdlog::error("Event frame cut short or past the end of {}", file.string());
+        return false;
+    }
+
+    auto* unp = get_unpacker(0x0000);
+    return unp->execute(get_current_event(), get_current_event(), 0x0000, source, *length);
+}
+
+auto partition_input(const std::filesystem::path& filepath, uint32_t n_parts) -> std::optional<std::vector<uint64_t>>
+{
+    std::ifstream in(filepath, std::ios_base::binary);
+    if (!in or !read_file_header(in)) {
+        return std::nullopt;
+    }
+
+    std::error_code ec;
+    const auto size = static_cast<uint64_t>(std::filesystem::file_size(filepath, ec));
+    if (ec) {
+        return std::nullopt;
+    }
+
+    const auto first = static_cast<uint64_t>(in.tellg());
+
+    std::vector<uint64_t> offsets {first};
+    auto offset = first;
+
+    for (uint32_t part = 1; part < n_parts; ++part) {
+        const auto target = first + (size - first) * part / n_parts;
+
+        while (offset < target) {
+            auto length = dst::read_varint(in);
+            if (!length) {
+                offset = size;
+                break;
+            }
+
+            in.seekg(static_cast<std::streamoff>(*length), std::ios::cur);
+            offset = std::min(static_cast<uint64_t>(in.tellg()), size);
+        }
+
+        offsets.push_back(offset);
+    }
+
+    offsets.push_back(size);
+
+    return offsets;
+}
+
+}  // namespace sabat::sim
@@ -0,0 +1,724 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+/**
+ * Differential test of the Citiroc decoders. Randomized and mutated .bin streams (all datatype combinations,
+ * truncations, bad event sizes, bit flips) are unpacked by the event_unpacker of the Citiroc unpackers, reading with
+ * the reference stream decoder and with each alternative decoder, into stub categories. Each stream gets a random
+ * lookup table which maps several channels to the same SiPM and random channel masks, so the merging of the hits, the
+ * masking and the skipping of fully masked events by their event size are run. The EventHeader and SiPMRaw objects
+ * are compared event by event, and the unmutated streams are checked to unpack all events.
+ *
+ * With --bench, the throughput of each alternative relative to the reference is reported instead.
+ *
+ * Usage: citiroc_decoder_diff_test [iterations [seed]]
+ *        citiroc_decoder_diff_test --bench [events]
+ */
+
+#include <sabat/citiroc_bin_decoder.hpp>
+#include <sabat/citiroc_bin_unpacker_base.hpp>
+#include <sabat/citiroc_buffer_decoder.hpp>
+#include <sabat/citiroc_types.hpp>
+#include <sabat/sabat_categories.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+namespace citiroc = spark::citiroc;
+namespace types = spark::citiroc::types;
+
+/// Category with the interface used by event_unpacker, keeps the objects of an event in the order of creation.
+class stub_category
+{
+public:
+    using locator = std::array<size_t, 2>;
+
+    template<typename T>
+    auto get_object(std::initializer_list<size_t> loc) -> T*
+    {
+        static_assert(std::is_same_v<T, SiPMRaw>);
+        const auto key = to_locator(loc);
+        for (auto& [obj_key, obj] : hits) {
+            if (obj_key == key) {
+                return &obj;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    auto make_object_unsafe(std::initializer_list<size_t> loc) -> T*
+    {
+        if constexpr (std::is_same_v<T, EventHeader>) {
+            return &headers.emplace_back();
+        } else {
+            static_assert(std::is_same_v<T, SiPMRaw>);
+            return &hits.emplace_back(to_locator(loc), SiPMRaw {}).second;
+        }
+    }
+
+    auto clear() -> void
+    {
+        headers.clear();
+        hits.clear();
+    }
+
+    std::vector<EventHeader> headers;
+    std::vector<std::pair<locator, SiPMRaw>> hits;
+
+private:
+    static auto to_locator(std::initializer_list<size_t> loc) -> locator
+    {
+        locator key {};
+        std::copy_n(loc.begin(), std::min(loc.size(), key.size()), key.begin());
+        return key;
+    }
+};
+
+/// Lookup table with the interface of SabatLookup, maps the channels of address 0 to (module, SiPM).
+struct stub_lookup
+{
+    auto get(std::initializer_list<size_t> key) const -> std::tuple<uint8_t, uint8_t>
+    {
+        const auto address = *key.begin();
+        const auto channel = *(key.begin() + 1);
+        if (address != 0 or channel >= table.size()) {
+            std::printf("lookup of unexpected key (%zu, %zu)\n", address, channel);
+            std::exit(EXIT_FAILURE);
+        }
+        return table[channel];
+    }
+
+    std::array<std::tuple<uint8_t, uint8_t>, 256> table {};
+};
+
+/// Lookup table and channel masks a stream is unpacked with.
+struct unpack_setup
+{
+    stub_lookup lookup;
+    std::array<uint64_t, 256> masks {};
+};
+
+/// SiPMRaw object as stored by the unpacker.
+struct raw_hit
+{
+    stub_category::locator key {};
+    int board {-1};
+    int channel {-1};
+    int sipm {-1};
+    int lgpha {0};
+    int hgpha {0};
+    float toa {0};
+    float tot {0};
+
+    auto operator==(const raw_hit&) const -> bool = default;
+};
+
+/// EventHeader object as stored by the unpacker.
+struct raw_header
+{
+    int board {-1};
+    uint64_t trgts {0};
+    uint64_t trgid {0};
+    uint64_t chmask {0};
+    int flags {0};
+    int nhits {0};
+
+    auto operator==(const raw_header&) const -> bool = default;
+};
+
+struct decoded_event
+{
+    raw_header header;
+    std::vector<raw_hit> hits;
+    bool complete {true};  ///< the unpacker read the whole event
+
+    auto operator==(const decoded_event&) const -> bool = default;
+};
+
+struct decoded_stream
+{
+    std::optional<types::file_header> file_header;
+    std::vector<decoded_event> events;
+};
+
+auto operator==(const types::file_header& a, const types::file_header& b) -> bool
+{
+    return a.firmware_ver == b.firmware_ver and a.janus_rel == b.janus_rel and a.board_id == b.board_id
+           and a.run == b.run and a.acq_mode == b.acq_mode and a.e_hists_nbins == b.e_hists_nbins
+           and a.toa_tot_unit == b.toa_tot_unit and a.time_lsb == b.time_lsb and a.run_timestamp == b.run_timestamp;
+}
+
+/**
+ * Unpack the events from the source with the event_unpacker of the acquisition mode, until the end of data or an event
+ * cut short. StorePha and StoreTime are those of the unpacker of the mode.
+ */
+template<uint8_t AcqMode, bool StorePha, bool StoreTime, typename Source>
+auto unpack_events(Source& source, const unpack_setup& setup, std::vector<decoded_event>& events) -> void
+{
+    stub_category cat_event_header;
+    stub_category cat_sipm_raw;
+    const stub_lookup* lookup = &setup.lookup;
+
+    citiroc::event_unpacker<AcqMode, StorePha, StoreTime, stub_category, const stub_lookup*> unpacker(
+        cat_event_header, cat_sipm_raw, lookup, setup.masks);
+
+    while (true) {
+        cat_event_header.clear();
+        cat_sipm_raw.clear();
+
+        const bool complete = unpacker.read_event(source);
+        if (cat_event_header.headers.empty()) {
+            break;
+        }
+
+        const auto& hdr = cat_event_header.headers.front();
+
+        auto& event = events.emplace_back();
+        event.header = {hdr.board, hdr.trgts, hdr.trgid, hdr.chmask, hdr.flags, hdr.nhits};
+        event.complete = complete;
+
+        for (const auto& [key, obj] : cat_sipm_raw.hits) {
+            event.hits.push_back({key, obj.board, obj.channel, obj.sipm, obj.lgpha, obj.hgpha, obj.toa, obj.tot});
+        }
+
+        if (!complete) {
+            break;
+        }
+    }
+}
+
+template<typename Source>
+auto unpack_events(uint8_t acq_mode, Source& source, const unpack_setup& setup, std::vector<decoded_event>& events)
+    -> void
+{
+    switch (acq_mode) {
+        case citiroc::acq_modes::spectroscopy:
+            unpack_events<citiroc::acq_modes::spectroscopy, true, false>(source, setup, events);
+            break;
+        case citiroc::acq_modes::timing:
+            unpack_events<citiroc::acq_modes::timing, false, true>(source, setup, events);
+            break;
+        default:
+            unpack_events<citiroc::acq_modes::spect_timing, true, true>(source, setup, events);
+            break;
+    }
+}
+
+using decoder_function = std::function<decoded_stream(uint8_t, const unpack_setup&, std::span<const std::byte>)>;
+
+/// Reference: the stream decoder as driven by bin_source and the unpackers.
+auto reference_decode(uint8_t acq_mode, const unpack_setup& setup, std::span<const std::byte> data) -> decoded_stream
+{
+    std::istringstream in(std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+
+    decoded_stream out;
+
+    auto fheader = citiroc::decoder::read_file_header(in);
+    if (!in) {
+        return out;
+    }
+    out.file_header = fheader;
+
+    unpack_events(acq_mode, in, setup, out.events);
+
+    return out;
+}
+
+auto buffer_decode(uint8_t acq_mode, const unpack_setup& setup, std::span<const std::byte> data) -> decoded_stream
+{
+    namespace bd = citiroc::buffer_decoder;
+
+    bd::cursor cur(data);
+
+    decoded_stream out;
+
+    out.file_header = bd::read_file_header(cur);
+    if (!out.file_header) {
+        return out;
+    }
+
+    unpack_events(acq_mode, cur, setup, out.events);
+
+    return out;
+}
+
+struct variant
+{
+    std::string_view name;
+    decoder_function decode;
+};
+
+/// Alternative decoders under test, each must match the reference.
+const std::array variants {
+    variant {"buffer_decoder", buffer_decode},
+};
+
+/*** Stream generation ***/
+
+class stream_builder
+{
+public:
+    template<typename T>
+    auto put(T v, size_t n = sizeof(T)) -> void
+    {
+        std::array<std::byte, sizeof(T)> bytes {};
+        std::memcpy(bytes.data(), &v, sizeof(T));
+        data.insert(data.end(), bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(n));
+    }
+
+    std::vector<std::byte> data;
+    std::vector<size_t> event_offsets;
+};
+
+auto random_hit(std::mt19937_64& rng, stream_builder& out, uint8_t channel, uint8_t datatype) -> void
+{
+    out.put<uint8_t>(channel);
+    out.put<uint8_t>(datatype);
+    if (datatype & citiroc::datatypes::lgpha) {
+        out.put<uint16_t>(rng() & 0x1fff);
+    }
+    if (datatype & citiroc::datatypes::hgpha) {
+        out.put<uint16_t>(rng() & 0x1fff);
+    }
+    if (datatype & citiroc::datatypes::toa) {
+        out.put<uint32_t>(static_cast<uint32_t>(rng()));
+    }
+    if (datatype & citiroc::datatypes::tot) {
+        out.put<uint16_t>(static_cast<uint16_t>(rng()));
+    }
+}
+
+/// Datatype of a hit: mostly the valid combinations of the four fields, sometimes any byte.
+auto random_datatype(std::mt19937_64& rng) -> uint8_t
+{
+    static constexpr std::array<uint8_t, 4> fields {
+        citiroc::datatypes::lgpha, citiroc::datatypes::hgpha, citiroc::datatypes::toa, citiroc::datatypes::tot};
+
+    if (rng() % 8 == 0) {
+        return static_cast<uint8_t>(rng());
+    }
+
+    uint8_t datatype {0};
+    const auto combination = rng() % 16;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (combination & (1u << i)) {
+            datatype |= fields[i];
+        }
+    }
+    return datatype;
+}
+
+auto random_stream(std::mt19937_64& rng, uint8_t acq_mode, int n_events) -> stream_builder
+{
+    stream_builder out;
+
+    out.put<uint16_t>(static_cast<uint16_t>(rng()));
+    out.put<uint32_t>(static_cast<uint32_t>(rng()), 3);
+    out.put<uint16_t>(static_cast<uint16_t>(rng()));
+    out.put<uint16_t>(static_cast<uint16_t>(rng()));
+    out.put<uint8_t>(acq_mode);
+    out.put<uint16_t>(static_cast<uint16_t>(rng()));
+    out.put<uint8_t>(static_cast<uint8_t>(rng()));
+    out.put<uint32_t>(static_cast<uint32_t>(rng()));
+    out.put<uint64_t>(rng());
+
+    uint64_t trgts = rng() % 1000;
+
+    for (int ev = 0; ev < n_events; ++ev) {
+        const auto start = out.data.size();
+        out.event_offsets.push_back(start);
+
+        trgts += rng() % 100000;
+
+        std::vector<uint8_t> channels;
+        if (acq_mode == citiroc::acq_modes::timing) {
+            const auto n_hits = rng() % 20;
+            for (size_t i = 0; i < n_hits; ++i) {
+                channels.push_back(static_cast<uint8_t>(rng() % 64));
+            }
+        }
+
+        out.put<uint16_t>(0);  // size, set below
+        out.put<uint8_t>(static_cast<uint8_t>(rng() % 2));
+        out.put<uint64_t>(trgts);
+
+        if (acq_mode == citiroc::acq_modes::timing) {
+            out.put<uint16_t>(static_cast<uint16_t>(channels.size()));
+        } else {
+            const auto chmask = rng() & rng();
+            out.put<uint64_t>(static_cast<uint64_t>(ev));
+            out.put<uint64_t>(chmask);
+            out.put<uint16_t>(static_cast<uint16_t>(rng() & 0xff));
+            for (uint8_t ch = 0; ch < 64; ++ch) {
+                if (chmask >> ch & 1u) {
+                    channels.push_back(ch);
+                }
+            }
+        }
+
+        for (auto ch : channels) {
+            random_hit(rng, out, ch, random_datatype(rng));
+        }
+
+        const auto evsize = static_cast<uint16_t>(out.data.size() - start);
+        std::memcpy(out.data.data() + start, &evsize, sizeof(evsize));
+    }
+
+    return out;
+}
+
+/// Lookup table mapping the channels to a few SiPMs, so that hits are merged, and channel masks from none to all.
+auto random_setup(std::mt19937_64& rng) -> unpack_setup
+{
+    unpack_setup setup;
+
+    for (auto& entry : setup.lookup.table) {
+        entry = {static_cast<uint8_t>(rng() % 4), static_cast<uint8_t>(rng() % 16)};
+    }
+
+    for (auto& mask : setup.masks) {
+        switch (rng() % 4) {
+            case 0:
+                mask = 0;
+                break;
+            case 1:
+                mask = rng() & rng();
+                break;
+            case 2:
+                mask = ~(rng() & rng());
+                break;
+            default:
+                mask = ~uint64_t {0};
+                break;
+        }
+    }
+
+    return setup;
+}
+
+/// Apply a random corruption, returns its description.
+auto mutate(std::mt19937_64& rng, stream_builder& stream) -> std::string
+{
+    auto& data = stream.data;
+
+    switch (rng() % 5) {
+        case 0: {
+            const auto size = rng() % (data.size() + 1);
+            data.resize(size);
+            return "truncated at " + std::to_string(size);
+        }
+        case 1: {
+            const auto n_flips = 1 + rng() % 8;
+            for (size_t i = 0; i < n_flips and !data.empty(); ++i) {
+                data[rng() % data.size()] ^= std::byte {static_cast<uint8_t>(1u << (rng() % 8))};
+            }
+            return std::to_string(n_flips) + " bit flips";
+        }
+        case 2: {
+            if (stream.event_offsets.empty()) {
+                return "none";
+            }
+            // the size is used only to skip fully masked events, off by a few bytes it lands inside the event
+            const auto offset = stream.event_offsets[rng() % stream.event_offsets.size()];
+            uint16_t evsize {0};
+            std::memcpy(&evsize, data.data() + offset, sizeof(evsize));
+            evsize = rng() % 2 == 0 ? static_cast<uint16_t>(rng()) : static_cast<uint16_t>(evsize + rng() % 17 - 8);
+            std::memcpy(data.data() + offset, &evsize, sizeof(evsize));
+            return "bad evsize " + std::to_string(evsize) + " at " + std::to_string(offset);
+        }
+        case 3: {
+            if (stream.event_offsets.empty()) {
+                return "none";
+            }
+            const auto offset = stream.event_offsets[rng() % stream.event_offsets.size()];
+            data[offset] = std::byte {0};
+            data[offset + 1] = std::byte {0};
+            return "zero evsize at " + std::to_string(offset);
+        }
+        default: {
+            const auto size = rng() % 64;
+            for (size_t i = 0; i < size; ++i) {
+                data.push_back(std::byte {static_cast<uint8_t>(rng())});
+            }
+            return std::to_string(size) + " garbage bytes appended";
+        }
+    }
+}
+
+/*** Comparison ***/
+
+auto describe(const raw_hit& hit) -> std::string
+{
+    return "key (" + std::to_string(hit.key[0]) + ", " + std::to_string(hit.key[1]) + ") channel "
+           + std::to_string(hit.channel) + " lgpha " + std::to_string(hit.lgpha) + " hgpha "
+           + std::to_string(hit.hgpha) + " toa " + std::to_string(hit.toa) + " tot " + std::to_string(hit.tot);
+}
+
+auto describe(const decoded_event& event) -> std::string
+{
+    std::string text = "brd " + std::to_string(event.header.board) + " trgts " + std::to_string(event.header.trgts)
+                       + " chmask " + std::to_string(event.header.chmask) + " nhits "
+                       + std::to_string(event.header.nhits) + " hits " + std::to_string(event.hits.size())
+                       + (event.complete ? "" : " incomplete");
+    return text;
+}
+
+auto compare(const decoded_stream& ref, const decoded_stream& alt, std::string_view name, std::string_view what)
+    -> bool
+{
+    if (ref.file_header.has_value() != alt.file_header.has_value()
+        or (ref.file_header and !(*ref.file_header == *alt.file_header)))
+    {
+        std::printf("[%.*s] %.*s: file header differs\n",
+                    static_cast<int>(name.size()),
+                    name.data(),
+                    static_cast<int>(what.size()),
+                    what.data());
+        return false;
+    }
+
+    const auto n_events = std::max(ref.events.size(), alt.events.size());
+    for (size_t i = 0; i < n_events; ++i) {
+        if (i < ref.events.size() and i < alt.events.size() and ref.events[i] == alt.events[i]) {
+            continue;
+        }
+
+        auto ref_text = i < ref.events.size() ? describe(ref.events[i]) : std::string("none");
+        auto alt_text = i < alt.events.size() ? describe(alt.events[i]) : std::string("none");
+
+        if (i < ref.events.size() and i < alt.events.size()) {
+            const auto& ref_hits = ref.events[i].hits;
+            const auto& alt_hits = alt.events[i].hits;
+            for (size_t h = 0; h < std::min(ref_hits.size(), alt_hits.size()); ++h) {
+                if (!(ref_hits[h] == alt_hits[h])) {
+                    ref_text += ", hit " + std::to_string(h) + ": " + describe(ref_hits[h]);
+                    alt_text += ", hit " + std::to_string(h) + ": " + describe(alt_hits[h]);
+                    break;
+                }
+            }
+        }
+
+        std::printf("[%.*s] %.*s: event %zu differs\n  reference: %s\n  %.*s: %s\n",
+                    static_cast<int>(name.size()),
+                    name.data(),
+                    static_cast<int>(what.size()),
+                    what.data(),
+                    i,
+                    ref_text.c_str(),
+                    static_cast<int>(name.size()),
+                    name.data(),
+                    alt_text.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+auto report(std::string_view what, size_t event, std::string_view problem) -> bool
+{
+    std::printf("%.*s: event %zu %.*s\n",
+                static_cast<int>(what.size()),
+                what.data(),
+                event,
+                static_cast<int>(problem.size()),
+                problem.data());
+    return false;
+}
+
+/**
+ * Properties of the unpacked events which do not depend on the decoder: masked channels are not stored, fully masked
+ * events of the spectroscopy modes have no hits, the objects are placed by the lookup table and hits of the same SiPM
+ * share the object. An unmutated stream must be unpacked completely.
+ */
+auto check_unpacked(const decoded_stream& out,
+                    uint8_t acq_mode,
+                    const unpack_setup& setup,
+                    std::optional<size_t> n_events,
+                    std::string_view what) -> bool
+{
+    if (n_events and (!out.file_header or out.events.size() != *n_events)) {
+        std::printf("%.*s: %zu of %zu events unpacked\n",
+                    static_cast<int>(what.size()),
+                    what.data(),
+                    out.events.size(),
+                    *n_events);
+        return false;
+    }
+
+    for (size_t i = 0; i < out.events.size(); ++i) {
+        const auto& event = out.events[i];
+        const auto mask = setup.masks[static_cast<size_t>(event.header.board)];
+
+        if (n_events and !event.complete) {
+            return report(what, i, "not complete");
+        }
+
+        if (acq_mode != citiroc::acq_modes::timing and event.header.chmask != 0
+            and (event.header.chmask & ~mask) == 0 and !event.hits.empty())
+        {
+            return report(what, i, "fully masked but has hits");
+        }
+
+        for (size_t h = 0; h < event.hits.size(); ++h) {
+            const auto& hit = event.hits[h];
+            const auto [mod, sipm] = setup.lookup.table[static_cast<size_t>(hit.channel)];
+
+            if (hit.channel < 64 and (mask >> hit.channel & 1u) != 0) {
+                return report(what, i, "stores masked channel " + std::to_string(hit.channel));
+            }
+            if (hit.key != stub_category::locator {mod, sipm} or hit.board != mod or hit.sipm != sipm) {
+                return report(what, i, "stores channel " + std::to_string(hit.channel) + " off its lookup entry");
+            }
+            for (size_t o = 0; o < h; ++o) {
+                if (event.hits[o].key == hit.key) {
+                    return report(what, i, "stores SiPM of channel " + std::to_string(hit.channel) + " twice");
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+auto mode_name(uint8_t acq_mode) -> std::string_view
+{
+    switch (acq_mode) {
+        case citiroc::acq_modes::spectroscopy:
+            return "spectroscopy";
+        case citiroc::acq_modes::timing:
+            return "timing";
+        default:
+            return "spect_timing";
+    }
+}
+
+/*** Throughput ***/
+
+template<typename Decoder>
+auto time_decoding(Decoder&& decode,
+                   uint8_t acq_mode,
+                   const unpack_setup& setup,
+                   std::span<const std::byte> data,
+                   int repeat) -> double
+{
+    size_t events {0};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        events += decode(acq_mode, setup, data).events.size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (events == 0) {
+        return 0;
+    }
+
+    return static_cast<double>(data.size()) * repeat / elapsed.count();
+}
+
+constexpr std::array modes {
+    citiroc::acq_modes::spectroscopy, citiroc::acq_modes::timing, citiroc::acq_modes::spect_timing};
+
+auto bench(int n_events) -> void
+{
+    std::mt19937_64 rng(20250101);
+
+    for (auto acq_mode : modes) {
+        auto stream = random_stream(rng, acq_mode, n_events);
+        const auto setup = random_setup(rng);
+
+        constexpr int repeat {3};
+        const auto ref_rate = time_decoding(reference_decode, acq_mode, setup, stream.data, repeat);
+
+        for (const auto& [name, decode] : variants) {
+            const auto rate = time_decoding(decode, acq_mode, setup, stream.data, repeat);
+            std::printf("%-12s %-16.*s %8.1f MB/s  reference %8.1f MB/s  ratio %.2f\n",
+                        mode_name(acq_mode).data(),
+                        static_cast<int>(name.size()),
+                        name.data(),
+                        rate / 1e6,
+                        ref_rate / 1e6,
+                        ref_rate > 0 ? rate / ref_rate : 0.);
+        }
+    }
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc > 1 and std::string_view(argv[1]) == "--bench") {
+        bench(argc > 2 ? std::atoi(argv[2]) : 100000);
+        return EXIT_SUCCESS;
+    }
+
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20250101;
+
+    std::mt19937_64 rng(seed);
+
+    int failures {0};
+    size_t compared_events {0};
+
+    for (int it = 0; it < iterations; ++it) {
+        const auto acq_mode = modes[static_cast<size_t>(it) % modes.size()];
+
+        auto stream = random_stream(rng, acq_mode, 1 + static_cast<int>(rng() % 50));
+        const auto setup = random_setup(rng);
+
+        std::string what = std::string(mode_name(acq_mode)) + " iteration " + std::to_string(it);
+        std::optional<size_t> n_events = stream.event_offsets.size();
+        if (it % 4 != 0) {
+            what += ", " + mutate(rng, stream);
+            n_events.reset();
+        }
+
+        const auto ref = reference_decode(acq_mode, setup, stream.data);
+        compared_events += ref.events.size();
+
+        if (!check_unpacked(ref, acq_mode, setup, n_events, what)) {
+            failures++;
+        }
+
+        for (const auto& [name, decode] : variants) {
+            if (!compare(ref, decode(acq_mode, setup, stream.data), name, what)) {
+                failures++;
+            }
+        }
+    }
+
+    std::printf("%d streams, %zu reference events compared, %d mismatches (seed %llu)\n",
+                iterations,
+                compared_events,
+                failures,
+                static_cast<unsigned long long>(seed));
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
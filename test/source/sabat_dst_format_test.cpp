@@ -0,0 +1,712 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+/**
+ * Tests of the compact DST format: exact round trip of random events through the writer and the reading of
+ * dst_source and dst_unpacker (frame sizes and frame_unpacker, into stub categories), including floats which are not
+ * multiples of 0.5 ns, NaN, -0.0 and negative values. Hits outside the SiPMRaw category are dropped by the unpacker,
+ * frames past the end of the file and truncated payloads are rejected, as are hits which cannot be stored, and the
+ * file header has the little-endian layout.
+ *
+ * With --bench, the same events are written as Citiroc .bin, compact DST and ROOT tree, and the decoding speed of the
+ * three is compared.
+ *
+ * Usage: sabat_dst_format_test [--bench [events]]
+ */
+
+#include <sabat/citiroc_bin_decoder.hpp>
+#include <sabat/citiroc_types.hpp>
+#include <sabat/sabat_categories.hpp>
+#include <sabat/sabat_dst_format.hpp>
+#include <sabat/sabat_dst_source.hpp>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+
+namespace fs = std::filesystem;
+namespace dst = sabat::dst;
+namespace citiroc = spark::citiroc;
+namespace types = spark::citiroc::types;
+
+struct event
+{
+    types::event_header header;
+    std::vector<dst::raw_hit> hits;
+};
+
+/// Category with the object interface used by frame_unpacker, keeps the objects of an event in the order of creation.
+/// Objects outside the dimensions of the category registered by the detector fail the test, as spark would not store
+/// them.
+class stub_category
+{
+public:
+    template<typename T>
+    auto get_object(std::initializer_list<size_t> loc) -> T*
+    {
+        static_assert(std::is_same_v<T, SiPMRaw>);
+        for (auto& [key, obj] : hits) {
+            if (key == std::pair {*loc.begin(), *(loc.begin() + 1)}) {
+                return &obj;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    auto make_object_unsafe(std::initializer_list<size_t> loc) -> T*
+    {
+        if constexpr (std::is_same_v<T, EventHeader>) {
+            return &headers.emplace_back();
+        } else {
+            static_assert(std::is_same_v<T, SiPMRaw>);
+            const auto board = *loc.begin();
+            const auto sipm = *(loc.begin() + 1);
+            if (board >= sabat::category_size::modules or sipm >= sabat::category_size::sipms) {
+                std::printf("SiPMRaw object outside the category (%zu, %zu)\n", board, sipm);
+                std::exit(EXIT_FAILURE);
+            }
+            return &hits.emplace_back(std::pair {board, sipm}, SiPMRaw {}).second;
+        }
+    }
+
+    auto clear() -> void
+    {
+        headers.clear();
+        hits.clear();
+    }
+
+    std::vector<EventHeader> headers;
+    std::vector<std::pair<std::pair<size_t, size_t>, SiPMRaw>> hits;
+};
+
+auto same_float(float a, float b) -> bool
+{
+    return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b);
+}
+
+auto same_hit(const dst::raw_hit& a, const dst::raw_hit& b) -> bool
+{
+    return a.board == b.board and a.channel == b.channel and a.sipm == b.sipm and a.lgpha == b.lgpha
+           and a.hgpha == b.hgpha and same_float(a.toa, b.toa) and same_float(a.tot, b.tot);
+}
+
+auto random_float(std::mt19937_64& rng) -> float
+{
+    switch (rng() % 5) {
+        case 0:
+            return std::numeric_limits<float>::quiet_NaN();
+        case 1:
+            return std::bit_cast<float>(static_cast<uint32_t>(rng()));
+        case 2:
+            return -1.f;
+        case 3:
+            return -0.f;
+        default:
+            return static_cast<float>(rng() % 100000) * 0.25f;
+    }
+}
+
+/// Event with hits of any content the format must keep exactly, each hit in its own SiPMRaw slot.
+auto random_event(std::mt19937_64& rng, uint64_t trgid) -> event
+{
+    event ev;
+    ev.header.brd = static_cast<uint8_t>(rng() % 2);
+    ev.header.trgts = rng();
+    ev.header.trgid = trgid;
+    ev.header.chmask = rng();
+    ev.header.flags = static_cast<uint16_t>(rng());
+
+    std::array<bool, sabat::category_size::modules * sabat::category_size::sipms> used {};
+
+    const auto n_hits = rng() % 20;
+    for (size_t i = 0; i < n_hits; ++i) {
+        const auto slot = rng() % used.size();
+        if (std::exchange(used[slot], true)) {
+            continue;
+        }
+
+        dst::raw_hit hit;
+        hit.board = static_cast<int>(slot / sabat::category_size::sipms);
+        hit.channel = static_cast<int>(rng() % 256);
+        hit.sipm = static_cast<int>(slot % sabat::category_size::sipms);
+        hit.lgpha = rng() % 3 == 0 ? -1 : static_cast<int>(rng() % 8192);
+        hit.hgpha = rng() % 3 == 0 ? 0 : static_cast<int>(rng() % 8192);
+        hit.toa = rng() % 2 ? static_cast<float>(rng() % 0x7fffffff) * 0.5f : random_float(rng);
+        hit.tot = rng() % 2 ? static_cast<float>(rng() % 0xffff) * 0.5f : random_float(rng);
+        ev.hits.push_back(hit);
+    }
+    ev.header.nhits = static_cast<uint16_t>(ev.hits.size());
+
+    return ev;
+}
+
+auto random_file_header(std::mt19937_64& rng, uint8_t acq_mode) -> types::file_header
+{
+    types::file_header fheader;
+    fheader.firmware_ver = static_cast<uint16_t>(rng());
+    fheader.janus_rel = static_cast<uint32_t>(rng());
+    fheader.board_id = static_cast<uint16_t>(rng());
+    fheader.run = static_cast<uint16_t>(rng());
+    fheader.acq_mode = acq_mode;
+    fheader.e_hists_nbins = static_cast<uint16_t>(rng());
+    fheader.toa_tot_unit = static_cast<uint8_t>(rng());
+    fheader.time_lsb = static_cast<uint32_t>(rng());
+    fheader.run_timestamp = rng();
+    return fheader;
+}
+
+/**
+ * Read the DST file as dst_source reads it and dst_unpacker unpacks it, with the frame sizes bounded by the size of the
+ * file and frame_unpacker, into stub categories. The callback gets each unpacked event.
+ *
+ * \return the file header, nullopt if the file header or a frame is rejected
+ */
+template<typename Callback>
+auto read_dst(const fs::path& path, Callback&& callback) -> std::optional<types::file_header>
+{
+    std::ifstream in(path, std::ios_base::binary);
+
+    uint16_t version {0};
+    auto fheader = dst::read_file_header(in, version);
+    if (!fheader) {
+        return std::nullopt;
+    }
+
+    uint64_t remaining = fs::file_size(path) - static_cast<uint64_t>(in.tellg());
+
+    stub_category cat_event_header;
+    stub_category cat_sipm_raw;
+
+    dst::frame_unpacker<stub_category> unpacker(cat_event_header, cat_sipm_raw);
+    unpacker.set_format_version(version);
+
+    event ev;
+
+    while (remaining > 0) {
+        cat_event_header.clear();
+        cat_sipm_raw.clear();
+
+        auto length = dst::read_frame_size(in, remaining);
+        if (!length or !unpacker.read_frame(in, *length) or cat_event_header.headers.size() != 1) {
+            return std::nullopt;
+        }
+
+        const auto& hdr = cat_event_header.headers.front();
+
+        ev.header = {};
+        ev.header.brd = static_cast<uint8_t>(hdr.board);
+        ev.header.trgts = hdr.trgts;
+        ev.header.trgid = hdr.trgid;
+        ev.header.chmask = hdr.chmask;
+        ev.header.flags = static_cast<uint16_t>(hdr.flags);
+        ev.header.nhits = static_cast<uint16_t>(hdr.nhits);
+
+        ev.hits.clear();
+        for (const auto& [key, obj] : cat_sipm_raw.hits) {
+            if (key != std::pair {static_cast<size_t>(obj.board), static_cast<size_t>(obj.sipm)}) {
+                return std::nullopt;
+            }
+            ev.hits.push_back({obj.board, obj.channel, obj.sipm, obj.toa, obj.tot, obj.lgpha, obj.hgpha});
+        }
+
+        callback(ev);
+    }
+
+    return fheader;
+}
+
+auto write_dst(const fs::path& path, const types::file_header& fheader, const std::vector<event>& events) -> bool
+{
+    dst::dst_writer writer;
+    bool ok = writer.open(path, fheader);
+    for (const auto& ev : events) {
+        ok = ok and writer.write_event(ev.header, ev.hits);
+    }
+    return writer.close() and ok;
+}
+
+auto check(bool condition, std::string_view what) -> bool
+{
+    if (!condition) {
+        std::printf("FAILED: %.*s\n", static_cast<int>(what.size()), what.data());
+    }
+    return condition;
+}
+
+auto test_round_trip(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250301);
+
+    const auto fheader = random_file_header(rng, citiroc::acq_modes::spectroscopy);
+
+    std::vector<event> events;
+    for (uint64_t i = 0; i < 20000; ++i) {
+        events.push_back(random_event(rng, i));
+    }
+
+    if (!check(write_dst(path, fheader, events), "writing DST")) {
+        return false;
+    }
+
+    size_t n_read {0};
+    bool same {true};
+
+    auto read_header = read_dst(path,
+                                [&](const event& ev)
+                                {
+                                    if (n_read >= events.size()) {
+                                        same = false;
+                                        return;
+                                    }
+
+                                    const auto& orig = events[n_read++];
+                                    same = same and ev.header.brd == orig.header.brd
+                                           and ev.header.trgts == orig.header.trgts
+                                           and ev.header.trgid == orig.header.trgid
+                                           and ev.header.chmask == orig.header.chmask
+                                           and ev.header.flags == orig.header.flags
+                                           and ev.header.nhits == orig.header.nhits
+                                           and ev.hits.size() == orig.hits.size();
+
+                                    for (size_t i = 0; same and i < ev.hits.size(); ++i) {
+                                        same = same_hit(ev.hits[i], orig.hits[i]);
+                                    }
+                                });
+
+    bool ok = check(read_header.has_value(), "reading DST");
+    ok = check(read_header and read_header->run == fheader.run and read_header->time_lsb == fheader.time_lsb
+                   and read_header->run_timestamp == fheader.run_timestamp,
+               "file header round trip")
+         and ok;
+    ok = check(same and n_read == events.size(), "events round trip") and ok;
+
+    std::printf("round trip: %zu events, %ju bytes\n", n_read, static_cast<uintmax_t>(fs::file_size(path)));
+
+    return ok;
+}
+
+auto test_out_of_range(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250304);
+
+    event ev;
+    ev.header.trgid = 1;
+    ev.hits = {dst::raw_hit {.board = 0, .channel = 3, .sipm = 3, .toa = 1.5f},
+               dst::raw_hit {.board = 2, .channel = 4, .sipm = 4, .toa = 2.f},
+               dst::raw_hit {.board = 1, .channel = 64, .sipm = 63, .lgpha = 7},
+               dst::raw_hit {.board = 3, .channel = 255, .sipm = 0},
+               dst::raw_hit {.board = 1, .channel = 5, .sipm = 64},
+               dst::raw_hit {.board = 0, .channel = 6, .sipm = -1},
+               dst::raw_hit {.board = 1, .channel = 7, .sipm = 1000}};
+
+    if (!check(write_dst(path, random_file_header(rng, citiroc::acq_modes::spectroscopy), {ev}), "writing DST")) {
+        return false;
+    }
+
+    std::vector<event> read;
+    auto ok = check(read_dst(path, [&](const event& e) { read.push_back(e); }).has_value(), "reading DST");
+    ok = check(read.size() == 1 and read[0].header.nhits == ev.hits.size(), "all hits of the frame counted") and ok;
+    ok = check(read.size() == 1 and read[0].hits.size() == 2 and same_hit(read[0].hits[0], ev.hits[0])
+                   and same_hit(read[0].hits[1], ev.hits[2]),
+               "hits outside the SiPMRaw category dropped")
+         and ok;
+
+    return ok;
+}
+
+auto test_frame_past_end(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250305);
+
+    std::vector<event> events;
+    for (uint64_t i = 0; i < 10; ++i) {
+        events.push_back(random_event(rng, i));
+    }
+
+    const auto fheader = random_file_header(rng, citiroc::acq_modes::timing);
+
+    bool ok {true};
+
+    // after the valid frames: a frame claiming far more bytes than the file holds, and a size cut in the varint
+    std::vector<std::byte> past_end;
+    dst::append_varint(past_end, uint64_t {1} << 40);
+    past_end.resize(past_end.size() + 2);
+
+    for (const auto& tail : {past_end, std::vector {std::byte {0x80}}}) {
+        if (!check(write_dst(path, fheader, events), "writing DST")) {
+            return false;
+        }
+
+        std::ofstream(path, std::ios_base::binary | std::ios_base::app)
+            .write(reinterpret_cast<const char*>(tail.data()), static_cast<std::streamsize>(tail.size()));
+
+        size_t n_read {0};
+        ok = check(!read_dst(path, [&](const event&) { n_read++; }), "frame past the end of the file rejected") and ok;
+        ok = check(n_read == events.size(), "frames before the bad frame read") and ok;
+    }
+
+    return ok;
+}
+
+auto test_truncated() -> bool
+{
+    std::mt19937_64 rng(20250302);
+
+    bool ok {true};
+    for (uint64_t i = 0; i < 2000 and ok; ++i) {
+        auto ev = random_event(rng, i);
+        if (ev.hits.empty()) {
+            continue;
+        }
+
+        std::vector<std::byte> payload;
+        dst::encode_event(ev.hits, payload);
+
+        const auto cut = 1 + rng() % payload.size();
+        ok = check(!dst::decode_event(std::span<const std::byte>(payload).first(payload.size() - cut), [](auto&) {}),
+                   "truncated payload rejected");
+    }
+
+    return ok;
+}
+
+auto test_not_storable() -> bool
+{
+    std::vector<std::byte> payload;
+
+    bool ok {true};
+    for (auto [board, channel] : {std::pair {0, -1}, std::pair {0, 256}, std::pair {-1, 0}}) {
+        std::array hits {dst::raw_hit {.board = board, .channel = channel, .sipm = 0}};
+        payload.clear();
+        ok = check(!dst::encode_event(hits, payload), "hit outside the key range rejected") and ok;
+    }
+
+    std::array hits {dst::raw_hit {.board = 1, .channel = 255, .sipm = 3}};
+    payload.clear();
+    ok = check(dst::encode_event(hits, payload), "hit at the key range limit accepted") and ok;
+
+    return ok;
+}
+
+auto test_byte_order() -> bool
+{
+    std::ostringstream out;
+    dst::write_le<uint32_t>(out, 0x01020304);
+    const auto bytes = out.str();
+
+    std::istringstream in(bytes);
+
+    return check(bytes == std::string("\x04\x03\x02\x01", 4), "little-endian layout")
+           and check(dst::read_le<uint32_t>(in) == 0x01020304, "little-endian read back");
+}
+
+/*** Benchmark ***/
+
+/// Events as unpacked from the Citiroc timing mode: identity lookup, times in 0.5 ns units, missing fields -1.
+auto citiroc_events(std::mt19937_64& rng, size_t n_events) -> std::vector<event>
+{
+    std::vector<event> events(n_events);
+
+    uint64_t trgts {0};
+    for (auto& ev : events) {
+        trgts += rng() % 100000;
+        ev.header.brd = static_cast<uint8_t>(rng() % 2);
+        ev.header.trgts = trgts;
+
+        const auto n_hits = rng() % 20;
+        for (size_t i = 0; i < n_hits; ++i) {
+            dst::raw_hit hit;
+            hit.board = ev.header.brd;
+            hit.channel = static_cast<int>(rng() % 64);
+            hit.sipm = hit.channel;
+            hit.lgpha = static_cast<int>(rng() % 8192);
+            hit.hgpha = static_cast<int>(rng() % 8192);
+            hit.toa = static_cast<float>(rng() % 0x7fffffff) * 0.5f;
+            hit.tot = static_cast<float>(rng() % 0xffff) * 0.5f;
+            ev.hits.push_back(hit);
+        }
+        ev.header.nhits = static_cast<uint16_t>(ev.hits.size());
+    }
+
+    return events;
+}
+
+template<typename T>
+auto put(std::ostream& out, T v, size_t n = sizeof(T)) -> void
+{
+    v = dst::little_endian(v);
+    out.write(reinterpret_cast<const char*>(&v), static_cast<std::streamsize>(n));
+}
+
+auto write_bin(const fs::path& path, const types::file_header& fheader, const std::vector<event>& events) -> void
+{
+    std::ofstream out(path, std::ios_base::binary);
+
+    put(out, std::byteswap(fheader.firmware_ver));
+    put(out, std::byteswap(fheader.janus_rel << 8), 3);
+    put(out, fheader.board_id);
+    put(out, fheader.run);
+    put(out, fheader.acq_mode);
+    put(out, fheader.e_hists_nbins);
+    put(out, fheader.toa_tot_unit);
+    put(out, fheader.time_lsb);
+    put(out, fheader.run_timestamp);
+
+    constexpr uint8_t datatype {citiroc::datatypes::lgpha | citiroc::datatypes::hgpha | citiroc::datatypes::toa
+                                | citiroc::datatypes::tot};
+
+    const auto header_size = citiroc::decoder::header_size(fheader.acq_mode);
+    constexpr size_t hit_size {12};
+
+    for (const auto& ev : events) {
+        put(out, static_cast<uint16_t>(header_size + ev.hits.size() * hit_size));
+        put(out, ev.header.brd);
+        put(out, ev.header.trgts);
+        put(out, ev.header.nhits);
+
+        for (const auto& hit : ev.hits) {
+            put(out, static_cast<uint8_t>(hit.channel));
+            put(out, datatype);
+            put(out, static_cast<uint16_t>(hit.lgpha));
+            put(out, static_cast<uint16_t>(hit.hgpha));
+            put(out, static_cast<uint32_t>(hit.toa * 2));
+            put(out, static_cast<uint16_t>(hit.tot * 2));
+        }
+    }
+}
+
+/// Decode the .bin file into SiPMRaw content as the timing unpacker does, returns the number of hits.
+auto read_bin(const fs::path& path) -> size_t
+{
+    std::ifstream in(path, std::ios_base::binary);
+
+    auto fheader = citiroc::decoder::read_file_header(in);
+
+    size_t n_hits {0};
+    std::vector<dst::raw_hit> hits;
+
+    while (auto header = citiroc::decoder::read_event_header(fheader.acq_mode, in)) {
+        if (!in) {
+            break;
+        }
+
+        hits.clear();
+        for (int i = 0; i < header->nhits; ++i) {
+            auto hit = citiroc::decoder::read_hit(in);
+
+            dst::raw_hit raw;
+            raw.board = header->brd;
+            raw.channel = hit.channel;
+            raw.sipm = hit.channel;
+            raw.lgpha = hit.lgpha.value_or(-1);
+            raw.hgpha = hit.hgpha.value_or(-1);
+            raw.toa = hit.toa ? static_cast<float>(*hit.toa) * 0.5f : -1.f;
+            raw.tot = hit.tot ? static_cast<float>(*hit.tot) * 0.5f : -1.f;
+            hits.push_back(raw);
+        }
+        n_hits += hits.size();
+    }
+
+    return n_hits;
+}
+
+struct tree_buffers
+{
+    ULong64_t trgts {0};
+    std::vector<int> board;
+    std::vector<int> channel;
+    std::vector<int> sipm;
+    std::vector<int> lgpha;
+    std::vector<int> hgpha;
+    std::vector<float> toa;
+    std::vector<float> tot;
+};
+
+auto write_root(const fs::path& path, const std::vector<event>& events) -> void
+{
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "RECREATE"));
+
+    auto* tree = new TTree("T", "SiPMRaw");  // owned by the file
+    tree_buffers buf;
+    tree->Branch("trgts", &buf.trgts);
+    tree->Branch("board", &buf.board);
+    tree->Branch("channel", &buf.channel);
+    tree->Branch("sipm", &buf.sipm);
+    tree->Branch("lgpha", &buf.lgpha);
+    tree->Branch("hgpha", &buf.hgpha);
+    tree->Branch("toa", &buf.toa);
+    tree->Branch("tot", &buf.tot);
+
+    for (const auto& ev : events) {
+        buf = {};
+        buf.trgts = ev.header.trgts;
+        for (const auto& hit : ev.hits) {
+            buf.board.push_back(hit.board);
+            buf.channel.push_back(hit.channel);
+            buf.sipm.push_back(hit.sipm);
+            buf.lgpha.push_back(hit.lgpha);
+            buf.hgpha.push_back(hit.hgpha);
+            buf.toa.push_back(hit.toa);
+            buf.tot.push_back(hit.tot);
+        }
+        tree->Fill();
+    }
+
+    file->Write();
+    file->Close();
+}
+
+/// Read all branches of the ROOT tree, returns the number of hits.
+auto read_root(const fs::path& path) -> size_t
+{
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "READ"));
+    auto* tree = file->Get<TTree>("T");
+
+    ULong64_t trgts {0};
+    std::vector<int>* board {nullptr};
+    std::vector<int>* channel {nullptr};
+    std::vector<int>* sipm {nullptr};
+    std::vector<int>* lgpha {nullptr};
+    std::vector<int>* hgpha {nullptr};
+    std::vector<float>* toa {nullptr};
+    std::vector<float>* tot {nullptr};
+
+    tree->SetBranchAddress("trgts", &trgts);
+    tree->SetBranchAddress("board", &board);
+    tree->SetBranchAddress("channel", &channel);
+    tree->SetBranchAddress("sipm", &sipm);
+    tree->SetBranchAddress("lgpha", &lgpha);
+    tree->SetBranchAddress("hgpha", &hgpha);
+    tree->SetBranchAddress("toa", &toa);
+    tree->SetBranchAddress("tot", &tot);
+
+    size_t n_hits {0};
+    for (Long64_t i = 0; i < tree->GetEntries(); ++i) {
+        tree->GetEntry(i);
+        n_hits += board->size();
+    }
+
+    tree->ResetBranchAddresses();
+
+    return n_hits;
+}
+
+template<typename Reader>
+auto time_reading(Reader&& read, int repeat, size_t& n_hits) -> double
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        n_hits = read();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeat;
+}
+
+auto bench(const fs::path& dir, size_t n_events) -> bool
+{
+    std::mt19937_64 rng(20250303);
+
+    const auto fheader = random_file_header(rng, citiroc::acq_modes::timing);
+    const auto events = citiroc_events(rng, n_events);
+
+    const auto bin_path = dir / "bench.bin";
+    const auto dst_path = dir / "bench.sdst";
+    const auto root_path = dir / "bench.root";
+
+    write_bin(bin_path, fheader, events);
+    write_root(root_path, events);
+
+    write_dst(dst_path, fheader, events);
+
+    constexpr int repeat {3};
+    size_t bin_hits {0};
+    size_t dst_hits {0};
+    size_t root_hits {0};
+
+    const auto bin_time = time_reading([&] { return read_bin(bin_path); }, repeat, bin_hits);
+    const auto dst_time = time_reading(
+        [&]
+        {
+            size_t n {0};
+            read_dst(dst_path, [&](const event& ev) { n += ev.header.nhits; });
+            return n;
+        },
+        repeat,
+        dst_hits);
+    const auto root_time = time_reading([&] { return read_root(root_path); }, repeat, root_hits);
+
+    std::printf("%zu events, %zu hits\n", n_events, bin_hits);
+    for (auto [name, path, seconds] : {std::tuple {"bin", bin_path, bin_time},
+                                       std::tuple {"sdst", dst_path, dst_time},
+                                       std::tuple {"root", root_path, root_time}})
+    {
+        std::printf("%-5s %10ju bytes %10.0f events/s  %6.2f x bin\n",
+                    name,
+                    static_cast<uintmax_t>(fs::file_size(path)),
+                    n_events / seconds,
+                    bin_time / seconds);
+    }
+
+    return check(bin_hits == dst_hits and bin_hits == root_hits, "same hits in all formats");
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    const auto dir = fs::temp_directory_path() / ("sabat_dst_format_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    bool ok {true};
+
+    if (argc > 1 and std::string_view(argv[1]) == "--bench") {
+        ok = bench(dir, argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000);
+    } else {
+        ok = test_round_trip(dir / "round_trip.sdst") and ok;
+        ok = test_out_of_range(dir / "out_of_range.sdst") and ok;
+        ok = test_frame_past_end(dir / "past_end.sdst") and ok;
+        ok = test_truncated() and ok;
+        ok = test_not_storable() and ok;
+        ok = test_byte_order() and ok;
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,446 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+/**
+ * Tests of the simulation input: random events written with sim_writer are read back as sim_source reads them and
+ * sim_unpacker unpacks them (frame sizes and frame_unpacker, into stub categories), tracks and deposits beyond their
+ * categories are dropped, and the digitization of the events gives the same SiPMRaw for any number of --sim-split
+ * partitions of the file.
+ *
+ * Usage: sabat_sim_test
+ */
+
+#include <sabat/sabat_categories.hpp>
+#include <sabat/sabat_dst_format.hpp>
+#include <sabat/sabat_sim_format.hpp>
+#include <sabat/sabat_sim_source.hpp>
+#include <sabat/sabat_task_digitization.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <ios>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+
+namespace fs = std::filesystem;
+namespace sim = sabat::sim;
+
+/// Category with the object interface used by frame_unpacker and event_digitizer, keeps the objects of an event in the
+/// order of creation. Objects outside the dimensions of the category registered by the detector fail the test, as
+/// spark would not store them.
+class stub_category
+{
+public:
+    stub_category(std::string_view name, std::initializer_list<size_t> dims)
+        : name(name)
+        , dims(dims)
+    {
+    }
+
+    template<typename T>
+    auto make_object_unsafe(std::initializer_list<size_t> loc) -> T*
+    {
+        bool inside {loc.size() == dims.size()};
+        for (size_t i = 0; inside and i < dims.size(); ++i) {
+            inside = *(loc.begin() + i) < dims[i];
+        }
+        if (!inside) {
+            std::printf("%.*s object outside the category\n", static_cast<int>(name.size()), name.data());
+            std::exit(EXIT_FAILURE);
+        }
+        return &objects<T>().emplace_back();
+    }
+
+    template<typename T>
+    auto get_object(int i) -> T*
+    {
+        return &objects<T>().at(static_cast<size_t>(i));
+    }
+
+    auto get_entries() const -> int
+    {
+        return static_cast<int>(headers.size() + tracks.size() + deposits.size() + raws.size());
+    }
+
+    auto clear() -> void
+    {
+        headers.clear();
+        tracks.clear();
+        deposits.clear();
+        raws.clear();
+    }
+
+    std::deque<EventHeader> headers;
+    std::deque<GeantTrack> tracks;
+    std::deque<GeantSiPMRaw> deposits;
+    std::deque<SiPMRaw> raws;
+
+private:
+    template<typename T>
+    auto objects() -> std::deque<T>&
+    {
+        if constexpr (std::is_same_v<T, EventHeader>) {
+            return headers;
+        } else if constexpr (std::is_same_v<T, GeantTrack>) {
+            return tracks;
+        } else if constexpr (std::is_same_v<T, GeantSiPMRaw>) {
+            return deposits;
+        } else {
+            static_assert(std::is_same_v<T, SiPMRaw>);
+            return raws;
+        }
+    }
+
+    std::string_view name;
+    std::vector<size_t> dims;
+};
+
+/// Categories of the simulation as registered by the detector.
+struct stub_event
+{
+    stub_category header {"EventHeader", {1}};
+    stub_category geant_track {"GeantTrack", {sabat::category_size::geant_tracks}};
+    stub_category geant_sipm {"GeantSiPMRaw", {sabat::category_size::geant_deposits}};
+    stub_category sipm_raw {"SiPMRaw", {sabat::category_size::modules, sabat::category_size::sipms}};
+
+    auto clear() -> void
+    {
+        header.clear();
+        geant_track.clear();
+        geant_sipm.clear();
+        sipm_raw.clear();
+    }
+};
+
+/// SiPMDigiPar with the same parameters for all boards.
+struct stub_digi_par
+{
+    auto get(std::initializer_list<uint8_t> /*board*/) const -> std::tuple<float, float, float, float, float, float>
+    {
+        return {200.f, 3.f, 20.f, 0.4f, 1.5f, 12.f};
+    }
+};
+
+struct sim_event
+{
+    uint64_t event {0};
+    std::vector<sim::track> tracks;
+    std::vector<sim::deposit> deposits;
+};
+
+auto check(bool condition, std::string_view what) -> bool
+{
+    if (!condition) {
+        std::printf("FAILED: %.*s\n", static_cast<int>(what.size()), what.data());
+    }
+    return condition;
+}
+
+auto same_float(float a, float b) -> bool
+{
+    return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b);
+}
+
+auto random_event(std::mt19937_64& rng, uint64_t event) -> sim_event
+{
+    std::uniform_real_distribution<float> energy(0.f, 2.f);
+    std::uniform_real_distribution<float> time(0.f, 500.f);
+
+    sim_event ev;
+    ev.event = event;
+
+    const auto n_tracks = rng() % 6;
+    for (size_t i = 0; i < n_tracks; ++i) {
+        ev.tracks.push_back({.track_id = static_cast<int>(i + 1),
+                             .parent_id = static_cast<int>(i),
+                             .pdg = rng() % 2 ? 22 : 11,
+                             .x = time(rng),
+                             .y = -time(rng),
+                             .z = time(rng),
+                             .px = energy(rng),
+                             .py = -energy(rng),
+                             .pz = energy(rng),
+                             .energy = energy(rng)});
+    }
+
+    const auto n_deposits = rng() % 40;
+    for (size_t i = 0; i < n_deposits; ++i) {
+        ev.deposits.push_back({.board = static_cast<int>(rng() % sabat::category_size::modules),
+                               .channel = static_cast<int>(rng() % sabat::category_size::sipms),
+                               .track_id = static_cast<int>(rng() % 6),
+                               .energy = energy(rng),
+                               .time = time(rng)});
+    }
+
+    return ev;
+}
+
+auto write_sim(const fs::path& path, const std::vector<sim_event>& events) -> bool
+{
+    sim::sim_writer writer;
+    bool ok = writer.open(path, 0x1234);
+    for (const auto& ev : events) {
+        ok = ok and writer.write_event(ev.event, ev.tracks, ev.deposits);
+    }
+    writer.close();
+    return ok;
+}
+
+/**
+ * Read the frames starting in [begin, end) of the simulation file as sim_source reads them and sim_unpacker unpacks
+ * them, with the frame sizes bounded by the size of the file and frame_unpacker, into the stub categories. The callback
+ * gets the categories of each event.
+ *
+ * \return false if the file header or a frame is rejected
+ */
+template<typename Callback>
+auto read_sim(const fs::path& path, uint64_t begin, uint64_t end, Callback&& callback) -> bool
+{
+    std::ifstream in(path, std::ios_base::binary);
+    if (!sim::read_file_header(in)) {
+        return false;
+    }
+
+    if (begin > static_cast<uint64_t>(in.tellg())) {
+        in.seekg(static_cast<std::streamoff>(begin));
+    }
+
+    uint64_t remaining = fs::file_size(path) - static_cast<uint64_t>(in.tellg());
+
+    stub_event cats;
+    sim::frame_unpacker<stub_category> unpacker(cats.header, cats.geant_track, cats.geant_sipm);
+
+    while (static_cast<uint64_t>(in.tellg()) < end and remaining > 0) {
+        cats.clear();
+
+        auto length = sabat::dst::read_frame_size(in, remaining);
+        if (!length or !unpacker.read_frame(in, *length) or cats.header.headers.size() != 1) {
+            return false;
+        }
+
+        callback(cats);
+    }
+
+    return true;
+}
+
+auto test_round_trip(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250501);
+
+    std::vector<sim_event> events;
+    for (uint64_t i = 0; i < 2000; ++i) {
+        events.push_back(random_event(rng, 1000 + i));
+    }
+
+    if (!check(write_sim(path, events), "writing simulation input")) {
+        return false;
+    }
+
+    size_t n_read {0};
+    bool same {true};
+
+    const auto read = read_sim(path,
+                               0,
+                               fs::file_size(path),
+                               [&](stub_event& cats)
+                               {
+                                   if (n_read >= events.size()) {
+                                       same = false;
+                                       return;
+                                   }
+
+                                   const auto& orig = events[n_read++];
+                                   const auto& hdr = cats.header.headers.front();
+                                   same = same and hdr.trgid == orig.event
+                                          and hdr.nhits == static_cast<int>(orig.deposits.size())
+                                          and cats.geant_track.tracks.size() == orig.tracks.size()
+                                          and cats.geant_sipm.deposits.size() == orig.deposits.size();
+
+                                   for (size_t i = 0; same and i < orig.tracks.size(); ++i) {
+                                       const auto& trk = cats.geant_track.tracks[i];
+                                       const auto& o = orig.tracks[i];
+                                       same = trk.track_id == o.track_id and trk.parent_id == o.parent_id
+                                              and trk.pdg == o.pdg and same_float(trk.x, o.x)
+                                              and same_float(trk.y, o.y) and same_float(trk.z, o.z)
+                                              and same_float(trk.px, o.px) and same_float(trk.py, o.py)
+                                              and same_float(trk.pz, o.pz) and same_float(trk.energy, o.energy);
+                                   }
+
+                                   for (size_t i = 0; same and i < orig.deposits.size(); ++i) {
+                                       const auto& dep = cats.geant_sipm.deposits[i];
+                                       const auto& o = orig.deposits[i];
+                                       same = dep.event == static_cast<int>(orig.event) and dep.board == o.board
+                                              and dep.channel == o.channel and dep.track_id == o.track_id
+                                              and same_float(dep.energy, o.energy) and same_float(dep.time, o.time);
+                                   }
+                               });
+
+    bool ok = check(read, "reading simulation input");
+    ok = check(same and n_read == events.size(), "events round trip") and ok;
+
+    return ok;
+}
+
+auto test_category_limits(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250502);
+
+    auto ev = random_event(rng, 7);
+    ev.tracks.resize(sabat::category_size::geant_tracks + 500, ev.tracks.empty() ? sim::track {} : ev.tracks.front());
+    ev.deposits.resize(sabat::category_size::geant_deposits + 76, sim::deposit {.board = 0, .channel = 1});
+
+    if (!check(write_sim(path, {ev}), "writing simulation input")) {
+        return false;
+    }
+
+    size_t n_read {0};
+    bool limited {false};
+
+    const auto read = read_sim(path,
+                               0,
+                               fs::file_size(path),
+                               [&](stub_event& cats)
+                               {
+                                   n_read++;
+                                   limited = cats.geant_track.tracks.size() == sabat::category_size::geant_tracks
+                                             and cats.geant_sipm.deposits.size() == sabat::category_size::geant_deposits
+                                             and cats.header.headers.front().nhits
+                                                     == static_cast<int>(ev.deposits.size());
+                               });
+
+    return check(read and n_read == 1 and limited, "tracks and deposits beyond the categories dropped");
+}
+
+/// SiPMRaw of an event as digitized.
+struct digitized_hit
+{
+    uint64_t event {0};
+    int board {-1};
+    int channel {-1};
+    float toa {0};
+    float tot {0};
+    int lgpha {0};
+    int hgpha {0};
+
+    auto operator==(const digitized_hit& o) const -> bool
+    {
+        return event == o.event and board == o.board and channel == o.channel and same_float(toa, o.toa)
+               and same_float(tot, o.tot) and lgpha == o.lgpha and hgpha == o.hgpha;
+    }
+};
+
+/// Digitize the events of each partition as the separate --sim-split jobs do, each with its own digitizer.
+auto digitize_partitions(const fs::path& path, uint32_t n_parts, uint64_t seed, size_t& n_events)
+    -> std::vector<digitized_hit>
+{
+    std::vector<digitized_hit> hits;
+    n_events = 0;
+
+    const auto offsets = sim::partition_input(path, n_parts);
+    if (!check(offsets and offsets->size() == n_parts + 1, "partition of the simulation input")) {
+        return hits;
+    }
+
+    const stub_digi_par params;
+    const auto* digi_par = &params;
+
+    for (uint32_t part = 0; part < n_parts; ++part) {
+        sim::event_digitizer digitizer(seed);
+
+        const auto read = read_sim(path,
+                                   (*offsets)[part],
+                                   (*offsets)[part + 1],
+                                   [&](stub_event& cats)
+                                   {
+                                       n_events++;
+                                       digitizer.execute(cats.geant_sipm, cats.sipm_raw, digi_par);
+                                       for (const auto& raw : cats.sipm_raw.raws) {
+                                           hits.push_back({cats.header.headers.front().trgid,
+                                                           raw.board,
+                                                           raw.channel,
+                                                           raw.toa,
+                                                           raw.tot,
+                                                           raw.lgpha,
+                                                           raw.hgpha});
+                                       }
+                                   });
+
+        check(read, "reading a partition");
+    }
+
+    return hits;
+}
+
+auto test_partitions(const fs::path& path) -> bool
+{
+    std::mt19937_64 rng(20250503);
+
+    std::vector<sim_event> events;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        events.push_back(random_event(rng, i));
+    }
+
+    if (!check(write_sim(path, events), "writing simulation input")) {
+        return false;
+    }
+
+    constexpr uint64_t seed {42};
+
+    size_t n_events {0};
+    const auto reference = digitize_partitions(path, 1, seed, n_events);
+
+    bool ok = check(n_events == events.size() and !reference.empty(), "digitization of the whole input");
+
+    for (uint32_t n_parts : {2u, 3u, 7u, 64u}) {
+        const auto split = digitize_partitions(path, n_parts, seed, n_events);
+        ok = check(n_events == events.size() and split == reference,
+                   "same digitization for " + std::to_string(n_parts) + " partitions")
+             and ok;
+    }
+
+    const auto other_seed = digitize_partitions(path, 1, seed + 1, n_events);
+    ok = check(other_seed != reference, "digitization depends on the seed") and ok;
+
+    return ok;
+}
+
+}  // namespace
+
+auto main() -> int
+{
+    const auto dir = fs::temp_directory_path() / ("sabat_sim_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    bool ok {true};
+
+    ok = test_round_trip(dir / "round_trip.ssim") and ok;
+    ok = test_category_limits(dir / "limits.ssim") and ok;
+    ok = test_partitions(dir / "partitions.ssim") and ok;
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
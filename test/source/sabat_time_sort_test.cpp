@@ -0,0 +1,193 @@
+/*************************************************************************
+ * Copyright (C) 2025, Rafał Lalik <rafal.lalik@uj.edu.pl>               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see LICENSE file.                             *
+ * For the list of contributors see README.md file.                      *
+ *************************************************************************/
+
+/**
+ * Tests of the time ordering of the hits: time_sorter against std::stable_sort for event sizes around the insertion
+ * sort limit (both sort paths), the capacity limit, and split_windows for window boundaries at and beyond the width.
+ *
+ * Usage: sabat_time_sort_test
+ */
+
+#include <sabat/sabat_time_sort.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using sorter_type = sabat::time_sorter<128>;
+
+auto check(bool condition, std::string_view what) -> bool
+{
+    if (!condition) {
+        std::printf("FAILED: %.*s\n", static_cast<int>(what.size()), what.data());
+    }
+    return condition;
+}
+
+/// Times with many ties, so the index order of equal times is exercised too.
+auto random_keys(std::mt19937_64& rng, size_t n) -> std::vector<sabat::time_key>
+{
+    std::uniform_int_distribution<int> toa(0, static_cast<int>(n));
+    std::vector<sabat::time_key> keys;
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back({.toa = 0.5f * static_cast<float>(toa(rng)), .index = static_cast<int16_t>(i)});
+    }
+    return keys;
+}
+
+auto test_sort() -> bool
+{
+    std::mt19937_64 rng(20250402);
+    bool ok {true};
+
+    const auto limit = sorter_type::insertion_sort_limit;
+    for (size_t n : {size_t {0}, size_t {1}, size_t {2}, limit - 1, limit, limit + 1, limit + 2, size_t {100}}) {
+        for (int round = 0; round < 50; ++round) {
+            auto keys = random_keys(rng, n);
+
+            sorter_type sorter;
+            for (const auto& key : keys) {
+                sorter.push(key.toa, key.index);
+            }
+            sorter.sort();
+
+            auto sorted = sorter.sorted();
+
+            // the same hits, each with its own time, in the order of std::stable_sort up to equal times
+            auto expected = keys;
+            std::ranges::stable_sort(expected, {}, &sabat::time_key::toa);
+
+            std::vector<int16_t> indexes;
+            bool same {sorted.size() == n};
+            for (size_t i = 0; same and i < n; ++i) {
+                same = sorted[i].toa == expected[i].toa and sorted[i].toa == keys[sorted[i].index].toa;
+                indexes.push_back(sorted[i].index);
+            }
+            std::ranges::sort(indexes);
+            for (size_t i = 0; same and i < n; ++i) {
+                same = indexes[i] == static_cast<int16_t>(i);
+            }
+
+            ok = check(same, n <= limit ? "insertion sort of the hits" : "std::sort of the hits") and ok;
+        }
+    }
+
+    return ok;
+}
+
+auto test_stable_insertion() -> bool
+{
+    // the insertion sort keeps equal times in the order of the hits
+    sorter_type sorter;
+    for (int16_t i = 0; i < 10; ++i) {
+        sorter.push(static_cast<float>(i % 3), i);
+    }
+    sorter.sort();
+
+    std::vector<int16_t> expected {0, 3, 6, 9, 1, 4, 7, 2, 5, 8};
+    std::vector<int16_t> indexes;
+    for (const auto& key : sorter.sorted()) {
+        indexes.push_back(key.index);
+    }
+
+    return check(indexes == expected, "insertion sort is stable");
+}
+
+auto test_capacity() -> bool
+{
+    sabat::time_sorter<4> sorter;
+    bool pushed {true};
+    for (int16_t i = 0; i < 4; ++i) {
+        pushed = sorter.push(4.f - i, i) and pushed;
+    }
+
+    bool ok = check(pushed, "push up to the capacity");
+    ok = check(!sorter.push(0.f, 4) and sorter.size() == 4, "push over the capacity rejected") and ok;
+
+    sorter.sort();
+    auto sorted = sorter.sorted();
+    ok = check(sorted.front().index == 3 and sorted.back().index == 0, "sort of a full buffer") and ok;
+
+    sorter.clear();
+    return check(sorter.size() == 0 and sorter.sorted().empty(), "clear") and ok;
+}
+
+auto windows_of(std::span<const sabat::time_key> hits, float width) -> std::vector<std::pair<size_t, size_t>>
+{
+    std::vector<std::pair<size_t, size_t>> windows;
+    sabat::split_windows(hits, width, [&](size_t begin, size_t end) { windows.emplace_back(begin, end); });
+    return windows;
+}
+
+auto test_windows() -> bool
+{
+    using windows = std::vector<std::pair<size_t, size_t>>;
+
+    bool ok = check(windows_of({}, 10.f).empty(), "no windows without hits");
+
+    std::vector<sabat::time_key> one {{.toa = 5.f, .index = 0}};
+    ok = check(windows_of(one, 10.f) == windows {{0, 1}}, "single hit window") and ok;
+
+    // the hit at exactly the width from the opening hit belongs to its window, the next opens a new one
+    std::vector<sabat::time_key> hits {{.toa = 0.f, .index = 0},
+                                       {.toa = 4.f, .index = 1},
+                                       {.toa = 10.f, .index = 2},
+                                       {.toa = 10.5f, .index = 3},
+                                       {.toa = 15.f, .index = 4},
+                                       {.toa = 20.5f, .index = 5},
+                                       {.toa = 50.f, .index = 6}};
+    ok = check(windows_of(hits, 10.f) == windows {{0, 3}, {3, 6}, {6, 7}}, "windows from the opening hit") and ok;
+
+    // the windows cover all hits, in order, without overlap
+    std::mt19937_64 rng(20250403);
+    for (int round = 0; round < 100; ++round) {
+        sorter_type sorter;
+        for (const auto& key : random_keys(rng, 1 + rng() % 100)) {
+            sorter.push(key.toa, key.index);
+        }
+        sorter.sort();
+
+        auto sorted = sorter.sorted();
+        auto split = windows_of(sorted, 3.f);
+
+        bool valid {!split.empty() and split.front().first == 0 and split.back().second == sorted.size()};
+        for (size_t w = 0; valid and w < split.size(); ++w) {
+            auto [begin, end] = split[w];
+            valid = begin < end and (w == 0 or split[w - 1].second == begin)
+                    and sorted[end - 1].toa - sorted[begin].toa <= 3.f
+                    and (end == sorted.size() or sorted[end].toa - sorted[begin].toa > 3.f);
+        }
+        ok = check(valid, "windows cover the hits") and ok;
+    }
+
+    return ok;
+}
+
+}  // namespace
+
+auto main() -> int
+{
+    bool ok {true};
+
+    ok = test_sort() and ok;
+    ok = test_stable_insertion() and ok;
+    ok = test_capacity() and ok;
+    ok = test_windows() and ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,39 +1,742 @@
+#include <sabat/citiroc_bin_decoder.hpp>
 #include <sabat/citiroc_bin_source.hpp>
+#include <sabat/citiroc_bin_unpacker_spect_timing.hpp>
 #include <sabat/citiroc_bin_unpacker_timing.hpp>
 #include <sabat/citiroc_bin_unpacker_spectroscopy.hpp>
 #include <sabat/sabat.hpp>
 #include <sabat/sabat_categories.hpp>
+#include <sabat/sabat_checkpoint.hpp>
+#include <sabat/sabat_columnar.hpp>
+#include <sabat/sabat_demand.hpp>
 #include <sabat/sabat_detector.hpp>
+#include <sabat/sabat_dst_source.hpp>
+#include <sabat/sabat_event_index.hpp>
+#include <sabat/sabat_hot_channels.hpp>
+#include <sabat/sabat_output.hpp>
+#include <sabat/sabat_processing_setup.hpp>
+#include <sabat/sabat_rate_monitor.hpp>
+#include <sabat/sabat_sim_source.hpp>
 
 #include <spark/core/writer_tree.hpp>
 #include <spark/parameters/parameters_ascii_source.hpp>
 #include <spark/spark.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fnmatch.h>
 
 #include <CLI/CLI.hpp>
+#include <TROOT.h>
 #include <fmt/core.h>
 
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr auto dst_extension = ".sdst";
+constexpr auto sim_extension = ".ssim";
+
+enum class input_kind
+{
+    citiroc,
+    dst,
+    simulation,
+};
+
+auto kind_of(const fs::path& input) -> input_kind
+{
+    if (input.extension() == dst_extension) {
+        return input_kind::dst;
+    }
+    if (input.extension() == sim_extension) {
+        return input_kind::simulation;
+    }
+    return input_kind::citiroc;
+}
+
+/// Input file to process into output file, for the simulation a partition of its events.
+struct analysis_job
+{
+    fs::path input;
+    fs::path output;
+    uint64_t range_begin {0};                                   ///< first simulation event frame to read
+    uint64_t range_end {std::numeric_limits<uint64_t>::max()};  ///< frames starting at or after are not read
+};
+
+/// Outputs of the simulation partitions, merged into the output of the input when all succeeded.
+struct partitioned_output
+{
+    fs::path input;
+    fs::path output;
+    std::vector<fs::path> parts;
+};
+
+struct analysis_options
+{
+    int64_t first_event {0};
+    int64_t n_events_to_process {0};
+    std::string ascii_par {"sabat_pars.txt"};
+    bool write_dst {false};
+    std::optional<sabat::columnar_format> columnar;  ///< export also to Arrow/Parquet
+    size_t columnar_batch {10000};
+    std::vector<SabatCategories> stored_categories;  ///< empty for all
+    size_t task_threads {1};
+    sabat::output_options output;
+    uint64_t sim_seed {0};
+    bool build_index {true};
+    int64_t checkpoint_interval {0};  ///< events between the checkpoints, 0 disabled
+    bool resume {false};
+    bool monitor {false};        ///< write the rate monitor time series next to the output
+    double monitor_tick {1e-6};  ///< trigger timestamp tick [s]
+    bool find_hot_channels {false};
+};
+
+/**
+ * Expand input arguments into list of files. Arguments containing wildcards are matched against the files in their
+ * parent directory, the others are taken as they are.
+ */
+auto expand_inputs(const std::vector<std::string>& args) -> std::vector<fs::path>
+{
+    std::vector<fs::path> files;
+
+    for (const auto& arg : args) {
+        if (arg.find_first_of("*?[") == std::string::npos) {
+            files.emplace_back(arg);
+            continue;
+        }
+
+        const auto pattern = fs::path(arg);
+        auto dir = pattern.parent_path();
+        if (dir.empty()) {
+            dir = fs::path(".");
+        }
+
+        std::vector<fs::path> matched;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.is_regular_file()
+                and fnmatch(pattern.filename().c_str(), entry.path().filename().c_str(), 0) == 0)
+            {
+                matched.push_back(entry.path());
+            }
+        }
+
+        if (matched.empty()) {
+            spdlog::warn("Pattern {:s} does not match any file", arg);
+        }
+
+        std::ranges::sort(matched);
+        files.insert(files.end(), matched.begin(), matched.end());
+    }
+
+    return files;
+}
+
+auto output_for(const fs::path& input, const fs::path& output_dir) -> fs::path
+{
+    return output_dir / (input.stem().string() + "_sabat.root");
+}
+
+auto monitor_output_for(const fs::path& output) -> fs::path
+{
+    return fs::path(output).replace_filename(output.stem().string() + "_monitor.csv");
+}
+
+auto hot_channels_output_for(const fs::path& output) -> fs::path
+{
+    return fs::path(output).replace_filename(output.stem().string() + "_channel_mask.txt");
+}
+
+/**
+ * Write the channel mask suggested by the hot channel detector, to be used in the parameters of the next run.
+ */
+auto write_hot_channels(sabat::hot_channel_detector& detector, const fs::path& filepath) -> void
+{
+    detector.finish();
+
+    std::ofstream out(filepath);
+    detector.write_mask(out);
+
+    if (!out) {
+        spdlog::warn("Cannot write channel mask {:s}", filepath.string());
+        return;
+    }
+
+    for (auto board : detector.board_list()) {
+        if (auto hot = detector.hot_mask(board); hot != 0) {
+            spdlog::warn("Hot channels on board {:d}: mask {:#018x}, suggested mask written to {:s}",
+                         board,
+                         hot,
+                         filepath.string());
+        }
+    }
+}
+
+/**
+ * Write the state of the rate monitor and the hot channel detector at the checkpoint of the given entries, aside and
+ * renamed like the checkpoint, so a resumed job writes these outputs for all its events.
+ */
+auto write_output_state(const fs::path& filepath, int64_t entries, const sabat::processing_setup& setup) -> bool
+{
+    auto tmp = filepath;
+    tmp += ".tmp";
+
+    {
+        std::ofstream out(tmp);
+        out << "entries " << entries << '\n';
+        if (setup.monitor) {
+            out << "monitor\n";
+            setup.monitor->write_state(out);
+        }
+        if (setup.hot_channels) {
+            out << "hot_channels\n";
+            setup.hot_channels->write_state(out);
+        }
+        out.flush();
+
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, filepath, ec);
+    return !ec;
+}
+
+/// Restore the state saved at the checkpoint of the given entries, false if there is none.
+auto read_output_state(const fs::path& filepath, int64_t entries, sabat::processing_setup& setup) -> bool
+{
+    std::ifstream in(filepath);
+
+    std::string key;
+    int64_t saved {-1};
+    if (!(in >> key >> saved) or key != "entries" or saved != entries) {
+        return false;
+    }
+
+    if (setup.monitor and !(in >> key and key == "monitor" and setup.monitor->read_state(in))) {
+        return false;
+    }
+
+    return !setup.hot_channels or (in >> key and key == "hot_channels" and setup.hot_channels->read_state(in));
+}
+
+auto write_monitor(const sabat::rate_monitor& monitor, const fs::path& filepath) -> void
+{
+    std::ofstream out(filepath);
+    monitor.write_csv(out);
+
+    if (!out) {
+        spdlog::warn("Cannot write monitor {:s}", filepath.string());
+        return;
+    }
+
+    spdlog::info("Monitor {:s}: {:d} bins of {:d} ticks", filepath.string(), monitor.used_bins(), monitor.bin_width());
+}
+
+/**
+ * Print the throughput and size of the written output, to compare the storage settings.
+ */
+auto report_output(const fs::path& input_file,
+                   const fs::path& output_file,
+                   double seconds,
+                   const sabat::output_options& output) -> void
+{
+    auto stats = sabat::read_output_stats(output_file, "T");
+    if (!stats) {
+        spdlog::warn("Cannot read back output {:s}", output_file.string());
+        return;
+    }
+
+    std::error_code ec;
+    const auto input_size = fs::file_size(input_file, ec);
+
+    constexpr double MB = 1024. * 1024.;
+
+    spdlog::info("Output {:s}: {:d} events in {:.2f} s, {:.0f} events/s, {:.1f} MB/s input, {:.1f} MB written, "
+                 "compression factor {:.2f} ({:s})",
+                 output_file.string(),
+                 stats->entries,
+                 seconds,
+                 seconds > 0 ? stats->entries / seconds : 0.,
+                 seconds > 0 ? input_size / MB / seconds : 0.,
+                 stats->file_size / MB,
+                 stats->compression_factor(),
+                 output.describe());
+}
+
+/**
+ * Position the input at the start of the job: at the last checkpoint of the output when resuming, otherwise at the
+ * first requested event. When resuming, the continuation of an interrupted resume is appended to the output and the
+ * output is cut back to the entries of the checkpoint, in place.
+ *
+ * \return state at the start of the job, nullopt on error
+ */
+template<typename Source>
+auto start_job(Source& src, const analysis_options& opts, const fs::path& input_file, const fs::path& output_file)
+    -> std::optional<sabat::checkpoint>
+{
+    constexpr bool seekable = requires { src.seek_to_offset(uint64_t {}); };
+
+    sabat::checkpoint start {.input = input_file, .run = src.header()->run};
+
+    auto ckpt = opts.resume ? sabat::read_checkpoint(sabat::checkpoint_file_for(output_file)) : std::nullopt;
+
+    if (!ckpt) {
+        if constexpr (seekable) {
+            if (opts.first_event > 0 and !src.skip_to_event(opts.first_event)) {
+                return std::nullopt;
+            }
+            start.event = opts.first_event;
+            start.offset = src.current_event_offset();
+        } else if (opts.first_event > 0) {
+            spdlog::warn("Skipping events is supported only for Citiroc input");
+        }
+        return start;
+    }
+
+    if constexpr (!seekable) {
+        spdlog::error("Resume is supported only for Citiroc input");
+        return std::nullopt;
+    } else {
+        if (ckpt->input != input_file or ckpt->run != start.run) {
+            spdlog::error(
+                "Checkpoint of {:s} is for input {:s} run {:d}", output_file.string(), ckpt->input.string(), ckpt->run);
+            return std::nullopt;
+        }
+
+        // the continuation of an interrupted resume is appended up to the checkpoint, the entries written after the
+        // checkpoint are cut off
+        const auto continuation = sabat::continuation_file_for(output_file);
+        if (fs::exists(continuation) and !sabat::append_output(output_file, continuation, "T", ckpt->entries)) {
+            spdlog::error("Cannot append {:s} to {:s}", continuation.string(), output_file.string());
+            return std::nullopt;
+        }
+
+        auto entries = sabat::cut_output(output_file, "T", ckpt->entries);
+        if (!entries or *entries != ckpt->entries) {
+            spdlog::error("Output {:s} does not hold the {:d} entries of its checkpoint",
+                          output_file.string(),
+                          ckpt->entries);
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        fs::remove(continuation, ec);
+
+        if (!src.seek_to_offset(ckpt->offset)) {
+            spdlog::error("Cannot seek {:s} to offset {:d}", input_file.string(), ckpt->offset);
+            return std::nullopt;
+        }
+
+        spdlog::info("Resuming {:s} at event {:d}, {:d} entries kept in {:s}",
+                     input_file.string(),
+                     ckpt->event,
+                     ckpt->entries,
+                     output_file.string());
+
+        return ckpt;
+    }
+}
+
+/**
+ * Process the jobs with the given source, until there are jobs left.
+ */
+template<typename Source>
+auto run_jobs(sabat::SabatMain& sabat,
+              Source& src,
+              const analysis_options& opts,
+              const std::vector<analysis_job>& jobs,
+              std::atomic<size_t>& next_job) -> int
+{
+    std::optional<uint16_t> current_run;
+    int failed {0};
+
+    auto& setup = sabat.setup();
+
+    for (auto job = next_job++; job < jobs.size(); job = next_job++) {
+        const auto& [input_file, output_file, range_begin, range_end] = jobs[job];
+
+        src.set_input(input_file);
+
+        if constexpr (requires { src.set_range(range_begin, range_end); }) {
+            src.set_range(range_begin, range_end);
+        }
+
+        if (!src.open()) {
+            spdlog::error("Skipping file {:s}", input_file.string());
+            failed++;
+            continue;
+        }
+
+        if (setup.columnar_output) {
+            auto columnar_file = fs::path(output_file).replace_extension(sabat::columnar_extension(*opts.columnar));
+            *setup.columnar_output = {columnar_file, *opts.columnar, opts.columnar_batch};
+        }
+
+        auto job_start = start_job(src, opts, input_file, output_file);
+        if (!job_start) {
+            spdlog::error("Skipping file {:s}", input_file.string());
+            src.close();
+            failed++;
+            continue;
+        }
+
+        const bool resumed = job_start->entries > 0;
+        const auto job_output = resumed ? sabat::continuation_file_for(output_file) : output_file;
+        const auto checkpoint_file = sabat::checkpoint_file_for(output_file);
+        const auto checkpoint_index_file = sabat::checkpoint_index_file_for(output_file);
+        const auto state_file = sabat::checkpoint_state_file_for(output_file);
+
+        if (setup.event_index) {
+            setup.event_index->clear();
+        }
+        bool index_complete = opts.build_index;
+
+        if (!resumed) {
+            std::error_code ec;
+            fs::remove(checkpoint_index_file, ec);
+            fs::remove(state_file, ec);
+        } else if (opts.build_index) {
+            if (auto saved = sabat::restore_checkpoint_index(checkpoint_index_file, job_start->entries)) {
+                *setup.event_index = std::move(*saved);
+            } else {
+                spdlog::warn("No event index of the {:d} checkpointed entries, event index of {:s} not written",
+                             job_start->entries,
+                             output_file.string());
+                index_complete = false;
+            }
+        }
+
+        if (setup.checkpoint) {
+            *setup.checkpoint = {};
+            if constexpr (requires { src.current_event_offset(); }) {
+                *setup.checkpoint = {checkpoint_file,
+                                     index_complete ? checkpoint_index_file : fs::path(),
+                                     job_output,
+                                     opts.checkpoint_interval,
+                                     *job_start,
+                                     [&src] { return src.current_event_offset(); }};
+                if (setup.monitor or setup.hot_channels) {
+                    setup.checkpoint->save_state = [&setup, state_file](int64_t entries)
+                    { return write_output_state(state_file, entries, setup); };
+                }
+            } else {
+                spdlog::warn("Checkpoints are supported only for Citiroc input");
+            }
+        }
+
+        if (setup.dst_output) {
+            const auto dst_file = fs::path(output_file).replace_extension(dst_extension);
+            if (!setup.dst_output->open(dst_file, *src.header())) {
+                spdlog::error(
+                    "Cannot open DST output {:s}, skipping file {:s}", dst_file.string(), input_file.string());
+                src.close();
+                failed++;
+                continue;
+            }
+        }
+
+        const auto run = src.header()->run;
+        if (current_run != run) {
+            sabat.init(run);
+            current_run = run;
+        }
+
+        spdlog::info("Processing {:s} -> {:s}", input_file.string(), job_output.string());
+
+        if (setup.monitor) {
+            setup.monitor->reset();
+        }
+        if (setup.hot_channels) {
+            setup.hot_channels->reset();
+        }
+        if (resumed and (setup.monitor or setup.hot_channels)
+            and !read_output_state(state_file, job_start->entries, setup))
+        {
+            spdlog::warn("No monitor and hot channel state of the {:d} checkpointed entries, their outputs of {:s} "
+                         "cover only the resumed events",
+                         job_start->entries,
+                         output_file.string());
+        }
+
+        // 0 processes all events, so a resumed job with no events left must not be started
+        auto n_events = opts.n_events_to_process;
+        bool done {false};
+        if (n_events > 0) {
+            n_events = std::max<int64_t>(n_events - job_start->entries, 0);
+            done = n_events == 0;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!done) {
+            auto writer = sabat.create_writer<spark::writer::tree>("T", job_output.string(), 0);
+            sabat::apply_output_options(job_output, "T", opts.output);
+            writer.process_data(n_events);
+        } else {
+            spdlog::info("Output {:s} already holds the requested events", output_file.string());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        src.close();
+        if (setup.checkpoint) {
+            *setup.checkpoint = {};
+        }
+
+        if (setup.dst_output and setup.dst_output->is_open() and !setup.dst_output->close()) {
+            spdlog::error("Cannot write DST output of {:s}", output_file.string());
+            failed++;
+        }
+
+        if (setup.monitor) {
+            write_monitor(*setup.monitor, monitor_output_for(output_file));
+        }
+
+        if (setup.hot_channels) {
+            write_hot_channels(*setup.hot_channels, hot_channels_output_for(output_file));
+        }
+
+        if (resumed and !done) {
+            if (!sabat::append_output(output_file, job_output, "T")) {
+                spdlog::error("Cannot append {:s} to {:s}", job_output.string(), output_file.string());
+                failed++;
+                continue;
+            }
+
+            std::error_code ec;
+            fs::remove(job_output, ec);
+        }
+
+        std::error_code ec;
+        fs::remove(checkpoint_file, ec);
+        fs::remove(checkpoint_index_file, ec);
+        fs::remove(state_file, ec);
+
+        if (index_complete and !sabat::write_event_index(output_file, *setup.event_index)) {
+            spdlog::warn("Cannot write event index of {:s}", output_file.string());
+        }
+
+        report_output(input_file, output_file, elapsed.count(), opts.output);
+    }
+
+    return failed;
+}
+
+/**
+ * Process a sequence of files with a single Sabat system. Unpackers for all supported acquisition modes are created
+ * once and selected per file from the file header, parameters are reinitialized only when the run number changes.
+ */
+auto process_files(const analysis_options& opts,
+                   const std::vector<analysis_job>& jobs,
+                   std::atomic<size_t>& next_job) -> int
+{
+    sabat::processing_setup setup;
+    setup.task_threads = opts.task_threads;
+
+    for (auto cat : opts.stored_categories) {
+        setup.demand.store(cat);
+    }
+
+    if (kind_of(jobs.front().input) == input_kind::simulation) {
+        setup.sim_seed = opts.sim_seed;
+    }
+    if (opts.build_index) {
+        setup.event_index.emplace();
+    }
+    if (opts.write_dst) {
+        setup.dst_output.emplace();
+    }
+    if (opts.columnar) {
+        setup.columnar_output.emplace();
+    }
+    if (opts.monitor) {
+        setup.monitor.emplace(static_cast<uint64_t>(1. / opts.monitor_tick), opts.monitor_tick);
+    }
+    if (opts.find_hot_channels) {
+        setup.hot_channels.emplace();
+    }
+    if (opts.checkpoint_interval > 0) {
+        setup.checkpoint.emplace();
+    }
+
+    auto sabat = sabat::SabatMain {std::move(setup)};
+
+    /*** Parameters and sources ***/
+    auto ascii_source = std::make_unique<spark::parameters_ascii_source>(opts.ascii_par);
+    sabat.pardb().add_source(ascii_source.get());
+
+    if (kind_of(jobs.front().input) == input_kind::simulation) {
+        auto sim_src = std::make_shared<sabat::sim::sim_source>();
+
+        auto sim_unp = sabat.tasks().make_unpacker<sabat::sim::sim_unpacker>("SabatSimUnpacker");
+        sim_src->add_unpacker(sim_unp, 0x0000);
+
+        sabat.add_source(sim_src.get());
+
+        return run_jobs(sabat, *sim_src, opts, jobs, next_job);
+    }
+
+    if (kind_of(jobs.front().input) == input_kind::dst) {
+        auto dst_src = std::make_shared<sabat::dst::dst_source>();
+
+        auto dst_unp = sabat.tasks().make_unpacker<sabat::dst::dst_unpacker>("SabatDstUnpacker");
+        dst_src->add_unpacker(dst_unp, 0x0000);
+
+        sabat.add_source(dst_src.get());
+
+        return run_jobs(sabat, *dst_src, opts, jobs, next_job);
+    }
+
+    auto citiroc_src = std::make_shared<spark::citiroc::bin_source>();
+    citiroc_src->register_hw_address(0x14520000, 0x0000);
+
+    auto spectroscopy_unp = sabat.tasks().make_unpacker<spark::citiroc::bin_unpacker_spectroscopy<SabatLookup>>(
+        "CitirocBinSpectroscopyUnpacker");
+    citiroc_src->add_mode_unpacker(spark::citiroc::acq_modes::spectroscopy, spectroscopy_unp);
+
+    auto timing_unp =
+        sabat.tasks().make_unpacker<spark::citiroc::bin_unpacker_timing<SabatLookup>>("CitirocBinTimingUnpacker");
+    citiroc_src->add_mode_unpacker(spark::citiroc::acq_modes::timing, timing_unp);
+
+    auto spect_timing_unp = sabat.tasks().make_unpacker<spark::citiroc::bin_unpacker_spect_timing<SabatLookup>>(
+        "CitirocBinSpectTimingUnpacker");
+    citiroc_src->add_mode_unpacker(spark::citiroc::acq_modes::spect_timing, spect_timing_unp);
+
+    sabat.add_source(citiroc_src.get());
+
+    return run_jobs(sabat, *citiroc_src, opts, jobs, next_job);
+}
+
+}  // namespace
+
 auto main(int argc, char** argv) -> int
 {
     CLI::App app {"Sabat DST application"};
     argv = app.ensure_utf8(argv);
 
-    int64_t first_event {0};
-    app.add_option("-f,--first", first_event, "number of events to skip")->check(CLI::PositiveNumber);
+    analysis_options opts;
 
-    int64_t n_events_to_process {0};
-    app.add_option("-e,--events", n_events_to_process, "number of events to analyze")->check(CLI::PositiveNumber);
+    app.add_option("-f,--first", opts.first_event, "number of events to skip")->check(CLI::PositiveNumber);
 
-    std::string ascii_par {"sabat_pars.txt"};
-    app.add_option("-a,--ascii", ascii_par, "ascii parameters file")->check(CLI::ExistingFile);
+    app.add_option("-e,--events", opts.n_events_to_process, "number of events to analyze")
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("-a,--ascii", opts.ascii_par, "ascii parameters file")->check(CLI::ExistingFile);
 
-    std::string input_file {};
-    app.add_option("input_file", input_file, "file to process")->check(CLI::ExistingFile);
+    std::vector<std::string> input_args {};
+    app.add_option("input_files", input_args, "files or glob patterns to process")->required();
 
     std::string output_file {"output_sabat.root"};
-    app.add_option("-o,--output", output_file, "output file");
+    auto* opt_output = app.add_option("-o,--output", output_file, "output file (single input only)");
+
+    std::string output_dir {"."};
+    app.add_option("--output-dir", output_dir, "output directory for multiple inputs")->excludes(opt_output);
+
+    unsigned int n_jobs {1};
+    app.add_option("-j,--jobs", n_jobs, "maximal number of files processed concurrently")
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("--task-threads",
+                   opts.task_threads,
+                   "threads running independent tasks of an event concurrently, per processed file")
+        ->check(CLI::PositiveNumber);
+
+    auto* opt_dst =
+        app.add_flag("--dst", opts.write_dst, "write also compact DST (.sdst) of the raw hits next to the output");
+
+    app.add_option("--checkpoint",
+                   opts.checkpoint_interval,
+                   "save the output and write a checkpoint (output.ckpt) every N events")
+        ->check(CLI::PositiveNumber);
+
+    auto* opt_resume = app.add_flag("--resume", opts.resume, "continue the outputs from their last checkpoints");
+
+    app.add_flag("--monitor",
+                 opts.monitor,
+                 "write trigger rate, dead time, channel occupancy and ToT overflow time series (_monitor.csv)");
+
+    app.add_option("--monitor-tick", opts.monitor_tick, "trigger timestamp tick in seconds, for the monitor rates")
+        ->check(CLI::PositiveNumber);
+
+    app.add_flag("--hot-channels",
+                 opts.find_hot_channels,
+                 "detect hot channels and write a suggested SabatChannelMask (_channel_mask.txt) for the next run");
+
+    bool no_index {false};
+    app.add_flag("--no-index",
+                 no_index,
+                 "do not write the event index (EventIndex tree) into the output, its energy is NaN when --store "
+                 "skips the PhotonHit reconstruction");
+
+    std::string columnar {};
+    auto* opt_columnar = app.add_option("--columnar",
+                   columnar,
+                   "export also SiPMRaw, SiPMCal and PhotonHit next to the output, format one of parquet, ipc")
+        ->check(
+            [](const std::string& name) -> std::string
+            {
+                if (!sabat::has_columnar_export()) {
+                    return "Built without Arrow support";
+                }
+                return sabat::columnar_format_from_name(name) ? std::string()
+                                                              : fmt::format("Unknown columnar format {:s}", name);
+            });
+
+    // DST and columnar outputs cannot be cut back to a checkpoint
+    opt_resume->excludes(opt_dst)->excludes(opt_columnar);
+
+    app.add_option("--columnar-batch", opts.columnar_batch, "events per Arrow record batch of the columnar export")
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("--seed", opts.sim_seed, "seed of the simulation digitization");
+
+    uint32_t sim_split {1};
+    app.add_option("--sim-split",
+                   sim_split,
+                   "split each simulation input into N partitions of consecutive events, processed as separate jobs "
+                   "and merged into the output")
+        ->check(CLI::PositiveNumber);
+
+    std::string compression {};
+    app.add_option("--compression",
+                   compression,
+                   "output compression as algorithm[:level], algorithm one of zlib, lzma, lz4, zstd, level 0-9");
+
+    app.add_option("--basket-size", opts.output.basket_size, "output basket size in bytes")
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("--autoflush",
+                   opts.output.auto_flush,
+                   "flush the output baskets every N entries (positive) or -N bytes (negative)");
+
+    app.add_option("--io-threads",
+                   opts.output.io_threads,
+                   "threads compressing the output baskets in parallel at the flushes (ROOT implicit MT), the events "
+                   "are still filled on the processing thread");
+
+    std::vector<std::string> store_names {};
+    app.add_option("--store",
+                   store_names,
+                   "categories needed in the output, tasks producing only other categories are skipped (default: all)")
+        ->check(
+            [](const std::string& name) -> std::string
+            { return sabat::category_from_name(name) ? std::string() : fmt::format("Unknown category {:s}", name); });
 
     bool debug_mode {false};
     app.add_flag("-d", debug_mode, "debug mode");
@@ -44,47 +747,151 @@ auto main(int argc, char** argv) -> int
         spdlog::set_level(spdlog::level::debug);
     }
 
+    opts.build_index = !no_index;
+
+    if (!columnar.empty()) {
+        opts.columnar = sabat::columnar_format_from_name(columnar);
+    }
+
+    if (!compression.empty()) {
+        const auto sep = compression.find(':');
+        auto algo = sabat::compression_algorithm_from_name(compression.substr(0, sep));
+        if (!algo) {
+            spdlog::error("Unknown compression algorithm {:s}", compression.substr(0, sep));
+            return 1;
+        }
+        opts.output.compression_algorithm = *algo;
+
+        if (sep != std::string::npos) {
+            const auto level = compression.substr(sep + 1);
+            if (level.size() != 1 or level[0] < '0' or level[0] > '9') {
+                spdlog::error("Invalid compression level in {:s}, expected 0-9", compression);
+                return 1;
+            }
+            opts.output.compression_level = level[0] - '0';
+        }
+    }
+
+    for (const auto& name : store_names) {
+        opts.stored_categories.push_back(*sabat::category_from_name(name));
+    }
+
+    const auto input_files = expand_inputs(input_args);
+
+    if (input_files.size() > 1 and opt_output->count() > 0) {
+        spdlog::error("Option --output requires a single input file, use --output-dir for multiple inputs");
+        return 1;
+    }
+
+    if (sim_split > 1 and (opts.write_dst or opts.columnar or opts.monitor or opts.find_hot_channels)) {
+        spdlog::error("Only the ROOT output of the --sim-split partitions is merged, it cannot be used with --dst, "
+                      "--columnar, --monitor or --hot-channels");
+        return 1;
+    }
+
+    std::vector<analysis_job> jobs;
+    std::vector<partitioned_output> partitioned;
+    for (const auto& input : input_files) {
+        if (!fs::is_regular_file(input)) {
+            spdlog::error("Input file {:s} does not exist", input.string());
+            return 1;
+        }
+
+        if (kind_of(input) != kind_of(input_files.front())) {
+            spdlog::error("Citiroc, DST and simulation input files cannot be mixed");
+            return 1;
+        }
+
+        const auto output = input_files.size() == 1 ? fs::path(output_file) : output_for(input, output_dir);
+
+        if (kind_of(input) != input_kind::simulation or sim_split == 1) {
+            jobs.push_back({input, output});
+            continue;
+        }
+
+        const auto offsets = sabat::sim::partition_input(input, sim_split);
+        if (!offsets) {
+            spdlog::error("Cannot partition simulation input {:s}", input.string());
+            return 1;
+        }
+
+        auto& parts = partitioned.emplace_back(partitioned_output {input, output, {}}).parts;
+        for (uint32_t part = 0; part < sim_split; ++part) {
+            auto part_output = output;
+            part_output.replace_filename(
+                fmt::format("{}_p{}{}", output.stem().string(), part, output.extension().string()));
+            jobs.push_back({input, part_output, (*offsets)[part], (*offsets)[part + 1]});
+            parts.push_back(part_output);
+        }
+    }
+
+    if (jobs.empty()) {
+        spdlog::error("No input files to process");
+        return 1;
+    }
+
+    std::vector<analysis_job> outputs = jobs;
+    for (const auto& [input, output, parts] : partitioned) {
+        outputs.push_back({input, output});
+    }
+
+    std::map<fs::path, fs::path> output_inputs;
+    for (const auto& job : outputs) {
+        auto [it, inserted] = output_inputs.emplace(fs::weakly_canonical(job.output), job.input);
+        if (!inserted) {
+            spdlog::error("Inputs {:s} and {:s} map to the same output {:s}, process them into different --output-dir",
+                          it->second.string(),
+                          job.input.string(),
+                          job.output.string());
+            return 1;
+        }
+    }
+
     //******************//
     // SPARK/SABAT part //
     //******************//
 
-    auto sabat = sabat::SabatMain {};
+    const auto n_workers = std::min<size_t>(n_jobs, jobs.size());
+    if (n_workers > 1 or opts.task_threads > 1) {
+        ROOT::EnableThreadSafety();
+    }
 
-    /*** Parameters and sources ***/
-    auto ascii_source = std::make_unique<spark::parameters_ascii_source>(ascii_par);
-    sabat.pardb().add_source(ascii_source.get());
+    // implicit MT is process wide, only the output trees use it here, see apply_output_options
+    if (opts.output.io_threads > 0) {
+        ROOT::EnableImplicitMT(opts.output.io_threads);
+    }
 
-    auto citiroc_src = std::make_shared<spark::citiroc::bin_source>();
-    citiroc_src->register_hw_address(0x14520000, 0x0000);
-    citiroc_src->set_input(input_file);
-
-    if (citiroc_src->open()) {
-        auto hdr = citiroc_src->header();
-
-        switch (hdr->acq_mode) {
-            case 0x01: {
-                auto citiroc_unp =
-                sabat.tasks().make_unpacker<spark::citiroc::bin_unpacker_spectroscopy<SabatLookup>>("CitirocBinSpectroscopyUnpacker");
-                citiroc_src->add_unpacker(citiroc_unp, 0x0000);
-            } break;
-            case 0x02: {
-                auto citiroc_unp =
-                    sabat.tasks().make_unpacker<spark::citiroc::bin_unpacker_timing<SabatLookup>>("CitirocBinTimingUnpacker");
-                citiroc_src->add_unpacker(citiroc_unp, 0x0000);
-            } break;
-            default: {
-                spdlog::error("Citiroc Acquisition Mode not supported by any unpacker");
-                std::exit(2);
-            }
+    std::atomic<size_t> next_job {0};
+    std::atomic<int> failed {0};
+
+    {
+        std::vector<std::jthread> workers;
+        for (size_t i = 1; i < n_workers; ++i) {
+            workers.emplace_back([&] { failed += process_files(opts, jobs, next_job); });
         }
+
+        failed += process_files(opts, jobs, next_job);
     }
 
-    sabat.add_source(citiroc_src.get());
+    if (failed > 0) {
+        spdlog::error("{:d} of {:d} files failed", failed.load(), jobs.size());
+        return 2;
+    }
 
-    sabat.init();
+    for (const auto& [input, output, parts] : partitioned) {
+        auto entries = sabat::merge_outputs(parts, output, "T");
+        if (!entries) {
+            spdlog::error("Cannot merge the partitions into {:s}", output.string());
+            return 2;
+        }
+
+        for (const auto& part : parts) {
+            std::error_code ec;
+            fs::remove(part, ec);
+        }
 
-    auto writer = sabat.create_writer<spark::writer::tree>("T", output_file, 0);
-    writer.process_data(n_events_to_process);
+        spdlog::info("Merged {:d} partitions into {:s}: {:d} events", parts.size(), output.string(), *entries);
+    }
 
     return 0;
 }